@@ -49,6 +49,7 @@ class MediapipeLlmModule(private val reactContext: ReactApplicationContext) :
     private external fun nativeCreateEngine(modelPath: String): Long
     private external fun nativeGenerateResponse(enginePtr: Long, prompt: String): String
     private external fun nativeDeleteEngine(enginePtr: Long)
+    private external fun nativeDumpLogs(maxRecords: Int): String
 
     @ReactMethod
     fun createModelFromAsset(
@@ -147,6 +148,17 @@ class MediapipeLlmModule(private val reactContext: ReactApplicationContext) :
         }
     }
 
+    // Recent native log records for field diagnostics; maxRecords <= 0
+    // returns everything retained.
+    @ReactMethod
+    fun dumpNativeLogs(maxRecords: Int, promise: Promise) {
+        try {
+            promise.resolve(nativeDumpLogs(maxRecords))
+        } catch (e: Exception) {
+            promise.reject("DUMP_LOGS_FAILED", e.localizedMessage)
+        }
+    }
+
     @ReactMethod
     fun getMemoryConfiguration(promise: Promise) {
         try {
@@ -4,11 +4,23 @@ import android.content.Context
 import android.content.pm.ApplicationInfo
 import android.content.pm.PackageManager
 import android.util.Log
+import org.json.JSONObject
 import java.io.File
 
 object ModelLoader {
     private const val TAG = "ModelLoader"
     
+    private val nativeInspectorAvailable: Boolean = try {
+        System.loadLibrary("MediapipeLlm")
+        true
+    } catch (e: UnsatisfiedLinkError) {
+        Log.w(TAG, "Native model inspector unavailable", e)
+        false
+    }
+    
+    // Returns the bundle's capabilities as JSON, or null if it can't be parsed.
+    private external fun nativeInspectModel(modelPath: String): String?
+    
     data class ConfigurationAnalysis(
         val recommendations: List<String>,
         val warnings: List<String>,
@@ -27,6 +39,34 @@ object ModelLoader {
         val recommendations: List<String>
     )
     
+    /**
+     * Reads context length, vocab, modalities, weight type and an estimated
+     * memory cost from a .task bundle without loading the model. Results are
+     * cached natively per file, so repeated calls are cheap.
+     */
+    fun inspectModel(modelPath: String): JSONObject? {
+        if (!nativeInspectorAvailable) return null
+        return try {
+            nativeInspectModel(modelPath)?.let { JSONObject(it) }
+        } catch (e: Exception) {
+            Log.w(TAG, "Failed to inspect model: ${e.message}")
+            null
+        }
+    }
+    
+    private fun readHeader(file: File, size: Int): ByteArray {
+        val header = ByteArray(minOf(size.toLong(), file.length()).toInt())
+        file.inputStream().use { input ->
+            var read = 0
+            while (read < header.size) {
+                val n = input.read(header, read, header.size - read)
+                if (n < 0) break
+                read += n
+            }
+        }
+        return header
+    }
+    
     fun analyzeAndRecommend(context: Context): ConfigurationAnalysis {
         val recommendations = mutableListOf<String>()
         val warnings = mutableListOf<String>()
@@ -150,7 +190,7 @@ object ModelLoader {
         
         // Check file header to validate format
         val isValidFormat = try {
-            val bytes = file.readBytes().take(16)
+            val bytes = readHeader(file, 16).toList()
             when (modelType) {
                 "task" -> {
                     // Task files typically start with specific bytes
@@ -232,7 +272,7 @@ object ModelLoader {
         }
         
         try {
-            val firstBytes = file.readBytes().take(64)
+            val firstBytes = readHeader(file, 64).toList()
             val hexDump = firstBytes.take(32).joinToString(" ") { "%02x".format(it) }
             
             analysis.add("Model Analysis:")
@@ -252,6 +292,13 @@ object ModelLoader {
                     analysis.add("  Format: MediaPipe Task (.task)")
                     analysis.add("  Compatibility: MediaPipe 0.10.24 with limitations")
                     analysis.add("  Recommendation: If loading fails, convert to .tflite")
+                    inspectModel(modelPath)?.let { caps ->
+                        analysis.add("  Context length: ${caps.optLong("contextLength", -1)}")
+                        analysis.add("  Vocab size: ${caps.optLong("vocabSize", -1)}")
+                        analysis.add("  Weight type: ${caps.optString("weightType", "unknown")}")
+                        analysis.add("  Vision: ${caps.optBoolean("supportsVision")}, Audio: ${caps.optBoolean("supportsAudio")}")
+                        analysis.add("  Estimated memory: ${caps.optLong("estimatedMemoryBytes") / 1024 / 1024}MB")
+                    }
                 }
                 isTfLiteFile -> {
                     analysis.add("  Format: TensorFlow Lite (.tflite)")
@@ -0,0 +1,200 @@
+#include "Autotuner.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#include <sys/sysctl.h>
+#endif
+
+namespace mediapipe_llm {
+
+namespace {
+
+constexpr const char* kCacheFileName = "mediapipe_llm_autotune.tsv";
+
+// FNV-1a; std::hash is not guaranteed to be stable across runs or libc++
+// versions, and the fingerprint is persisted.
+std::string fingerprint(const std::string& input) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : input) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return buffer;
+}
+
+std::string readFirstLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+double estimatedSeconds(const AutotuneMeasurement& m) {
+    return Autotuner::kReferencePromptTokens / m.prefillTokensPerSec +
+           Autotuner::kReferenceDecodeTokens / m.decodeTokensPerSec;
+}
+
+} // namespace
+
+Autotuner::Autotuner(const std::string& cacheDir) : cacheDir_(cacheDir) {}
+
+std::string Autotuner::deviceFingerprint() {
+    std::ostringstream ss;
+
+    struct utsname info = {};
+    if (uname(&info) == 0) {
+        ss << info.sysname << '/' << info.machine << '/' << info.release << ';';
+    }
+    ss << "cpus=" << std::thread::hardware_concurrency() << ';';
+
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    for (const char* prop : {"ro.product.model", "ro.board.platform", "ro.build.fingerprint"}) {
+        __system_property_get(prop, value);
+        ss << prop << '=' << value << ';';
+    }
+#elif defined(__APPLE__)
+    char model[64] = {};
+    size_t size = sizeof(model);
+    if (sysctlbyname("hw.machine", model, &size, nullptr, 0) == 0) {
+        ss << "model=" << model << ';';
+    }
+#endif
+
+    // Per-core max frequencies distinguish SoC bins that share a model name.
+    for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu) {
+        ss << readFirstLine("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/cpuinfo_max_freq") << ',';
+    }
+
+    return fingerprint(ss.str());
+}
+
+std::string Autotuner::modelFingerprint(const std::string& modelPath) {
+    struct stat st = {};
+    if (stat(modelPath.c_str(), &st) != 0) {
+        return "";
+    }
+
+    std::string name = modelPath.substr(modelPath.find_last_of('/') + 1);
+    std::ostringstream ss;
+    ss << name << ';' << st.st_size << ';' << st.st_mtime;
+    return fingerprint(ss.str());
+}
+
+size_t Autotuner::residentMemoryBytes() {
+#ifdef __APPLE__
+    mach_task_basic_info_data_t info = {};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+        return static_cast<size_t>(info.resident_size);
+    }
+    return 0;
+#else
+    std::ifstream statm("/proc/self/statm");
+    size_t totalPages = 0;
+    size_t residentPages = 0;
+    if (statm >> totalPages >> residentPages) {
+        return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+    return 0;
+#endif
+}
+
+bool Autotuner::lookup(const std::string& modelPath, const AutotuneConstraints& constraints, AutotuneResult& result) const {
+    if (cacheDir_.empty()) {
+        return false;
+    }
+
+    std::string key = cacheKey(modelPath, constraints);
+    std::ifstream file(cacheFile());
+    std::string line;
+
+    // Later lines win so re-tuning simply appends.
+    bool found = false;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string lineKey;
+        AutotuneResult entry;
+        if (!(fields >> lineKey >> entry.candidate.preferredBackend >> entry.candidate.activationDataType
+                     >> entry.measurement.prefillTokensPerSec >> entry.measurement.decodeTokensPerSec
+                     >> entry.measurement.peakMemoryBytes)) {
+            continue;
+        }
+        if (lineKey == key) {
+            entry.ok = true;
+            entry.fromCache = true;
+            entry.measurement.ok = true;
+            result = entry;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+AutotuneResult Autotuner::tune(const std::string& modelPath,
+                               const AutotuneConstraints& constraints,
+                               const std::vector<AutotuneCandidate>& candidates,
+                               const BenchmarkFn& benchmark) {
+    AutotuneResult best;
+
+    for (const auto& candidate : candidates) {
+        AutotuneMeasurement measurement = benchmark(candidate);
+        if (!measurement.ok || measurement.prefillTokensPerSec <= 0 || measurement.decodeTokensPerSec <= 0) {
+            continue;
+        }
+        if (constraints.memoryCeilingBytes > 0 && measurement.peakMemoryBytes > constraints.memoryCeilingBytes) {
+            continue;
+        }
+        if (!best.ok || estimatedSeconds(measurement) < estimatedSeconds(best.measurement)) {
+            best.ok = true;
+            best.candidate = candidate;
+            best.measurement = measurement;
+        }
+    }
+
+    if (best.ok) {
+        store(cacheKey(modelPath, constraints), best);
+    }
+
+    return best;
+}
+
+std::string Autotuner::cacheKey(const std::string& modelPath, const AutotuneConstraints& constraints) const {
+    return deviceFingerprint() + "-" + modelFingerprint(modelPath) +
+           "-m" + std::to_string(constraints.memoryCeilingBytes) + "-t" + std::to_string(constraints.maxNumTokens);
+}
+
+std::string Autotuner::cacheFile() const {
+    return cacheDir_ + "/" + kCacheFileName;
+}
+
+void Autotuner::store(const std::string& key, const AutotuneResult& result) const {
+    if (cacheDir_.empty()) {
+        return;
+    }
+
+    std::ofstream file(cacheFile(), std::ios::app);
+    file << key << '\t'
+         << result.candidate.preferredBackend << '\t'
+         << result.candidate.activationDataType << '\t'
+         << result.measurement.prefillTokensPerSec << '\t'
+         << result.measurement.decodeTokensPerSec << '\t'
+         << result.measurement.peakMemoryBytes << '\n';
+}
+
+} // namespace mediapipe_llm
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace mediapipe_llm {
+
+// One point in the search space. Values are the raw LlmPreferredBackend and
+// LlmActivationDataType enum values so this header stays free of MediaPipe.
+struct AutotuneCandidate {
+    int preferredBackend = 0;
+    int activationDataType = 0;
+};
+
+struct AutotuneMeasurement {
+    bool ok = false;
+    std::string error;
+    double prefillTokensPerSec = 0.0;
+    double decodeTokensPerSec = 0.0;
+    // Highest process RSS sampled while the engine loads, prefills and
+    // decodes, less the RSS before it was created. CPU-resident memory only:
+    // GPU allocations mostly don't show up in RSS, and anything else the app
+    // loads meanwhile is counted too.
+    size_t peakMemoryBytes = 0;
+};
+
+// What a stored result is valid for. A winner found with no memory ceiling,
+// or for a shorter context, says nothing about a tighter configuration, so
+// both are part of the cache key.
+struct AutotuneConstraints {
+    // Compared against peakMemoryBytes, so it bounds CPU-resident memory
+    // only and does not reliably limit GPU candidates. 0 = no ceiling.
+    size_t memoryCeilingBytes = 0;
+    size_t maxNumTokens = 0;
+};
+
+struct AutotuneResult {
+    bool ok = false;
+    bool fromCache = false;
+    AutotuneCandidate candidate;
+    AutotuneMeasurement measurement;
+};
+
+// Benchmarks engine configurations on the running device and remembers the
+// winner per (device, model, constraints) so later engine creations skip the
+// search. A search loads one engine per candidate and takes tens of seconds;
+// never run it on the JS thread.
+class Autotuner {
+public:
+    using BenchmarkFn = std::function<AutotuneMeasurement(const AutotuneCandidate&)>;
+
+    // Workload used to rank candidates: the estimated time to prefill and then
+    // decode this many tokens. Prefill dominates chat turns with long history.
+    static constexpr size_t kReferencePromptTokens = 512;
+    static constexpr size_t kReferenceDecodeTokens = 128;
+
+    // `cacheDir` may be empty, in which case results are not persisted.
+    explicit Autotuner(const std::string& cacheDir);
+
+    static std::string deviceFingerprint();
+    static std::string modelFingerprint(const std::string& modelPath);
+
+    // Resident set size of this process, or 0 where it cannot be read.
+    static size_t residentMemoryBytes();
+
+    bool lookup(const std::string& modelPath, const AutotuneConstraints& constraints, AutotuneResult& result) const;
+
+    // Runs `benchmark` over every candidate, discards failures and those whose
+    // peak memory exceeds the ceiling, and persists the fastest survivor.
+    AutotuneResult tune(const std::string& modelPath,
+                        const AutotuneConstraints& constraints,
+                        const std::vector<AutotuneCandidate>& candidates,
+                        const BenchmarkFn& benchmark);
+
+private:
+    std::string cacheKey(const std::string& modelPath, const AutotuneConstraints& constraints) const;
+    std::string cacheFile() const;
+    void store(const std::string& key, const AutotuneResult& result) const;
+
+    std::string cacheDir_;
+};
+
+} // namespace mediapipe_llm
@@ -0,0 +1,220 @@
+#include "DraftPrefill.h"
+#include "ThreadPlacement.h"
+
+namespace mediapipe_llm {
+
+namespace {
+
+const char* kWhitespace = " \t\r\n";
+
+bool isPrefix(const std::string& prefix, const std::string& text) {
+    return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string trimTrailingWhitespace(const std::string& text) {
+    size_t end = text.find_last_not_of(kWhitespace);
+    return end == std::string::npos ? "" : text.substr(0, end + 1);
+}
+
+// The longest prefix of `target` that extends `head` by at most
+// kMaxChunkChars, cut at whitespace like the stable prefix itself. A single
+// word longer than that goes in whole.
+std::string chunkEnd(const std::string& head, const std::string& target) {
+    if (target.size() - head.size() <= DraftPrefill::kMaxChunkChars) {
+        return target;
+    }
+    size_t cut = target.find_last_of(kWhitespace, head.size() + DraftPrefill::kMaxChunkChars);
+    if (cut != std::string::npos && cut > head.size()) {
+        std::string chunk = trimTrailingWhitespace(target.substr(0, cut));
+        if (chunk.size() > head.size()) {
+            return chunk;
+        }
+    }
+    size_t wordEnd = target.find_first_of(kWhitespace, head.size() + DraftPrefill::kMaxChunkChars);
+    return wordEnd == std::string::npos ? target : target.substr(0, wordEnd);
+}
+
+} // namespace
+
+DraftPrefill::DraftPrefill(void* baseSession, DraftSessionOps ops, size_t maxCheckpoints)
+    : ops_(std::move(ops)), maxCheckpoints_(maxCheckpoints) {
+    // The root clone is taken on the caller's thread so the base session is
+    // never touched concurrently with the caller's own use of it.
+    void* root = ops_.clone(baseSession);
+    if (!root) {
+        return;
+    }
+    checkpoints_.push_back(Checkpoint{root, ""});
+    valid_ = true;
+    worker_ = std::thread(&DraftPrefill::run, this);
+}
+
+DraftPrefill::~DraftPrefill() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    for (auto& checkpoint : checkpoints_) {
+        ops_.release(checkpoint.session);
+    }
+}
+
+std::string DraftPrefill::stablePrefix(const std::string& draft) {
+    std::string trimmed = trimTrailingWhitespace(draft);
+    if (trimmed.size() != draft.size()) {
+        // Trailing whitespace: the last word is complete. The whitespace
+        // itself belongs to whatever token comes next.
+        return trimmed;
+    }
+    size_t lastBreak = trimmed.find_last_of(kWhitespace);
+    if (lastBreak == std::string::npos) {
+        return "";
+    }
+    return trimTrailingWhitespace(trimmed.substr(0, lastBreak));
+}
+
+void DraftPrefill::update(const std::string& draft) {
+    if (!valid()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        target_ = draft;
+    }
+    changed_.notify_all();
+}
+
+void* DraftPrefill::commit(const std::string& finalText, std::string& error) {
+    if (!valid()) {
+        error = "Draft session could not be created";
+        return nullptr;
+    }
+    if (!worker_.joinable()) {
+        error = "Draft was already committed";
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    worker_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    rewindLocked(finalText);
+
+    Checkpoint head = checkpoints_.back();
+    checkpoints_.pop_back();
+    stats_.prefilledChars = head.text.size();
+    for (auto& checkpoint : checkpoints_) {
+        ops_.release(checkpoint.session);
+    }
+    checkpoints_.clear();
+
+    std::string tail = finalText.substr(head.text.size());
+    if (!tail.empty() && !ops_.addQueryChunk(head.session, tail)) {
+        ops_.release(head.session);
+        error = "Failed to add the remaining query text";
+        return nullptr;
+    }
+
+    return head.session;
+}
+
+void DraftPrefill::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+}
+
+bool DraftPrefill::isStopped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return workerExited_ || !valid_;
+}
+
+DraftPrefillStats DraftPrefill::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DraftPrefillStats stats = stats_;
+    if (!checkpoints_.empty()) {
+        stats.prefilledChars = checkpoints_.back().text.size();
+    }
+    return stats;
+}
+
+void DraftPrefill::run() {
+    // Typing-time prefill is opportunistic and must not compete with the UI.
+    ThreadPlacement::shared().placeCurrentThread(ThreadRole::Background);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        std::string stable;
+        changed_.wait(lock, [&] {
+            if (stopping_) return true;
+            stable = stablePrefix(target_);
+            const std::string& head = checkpoints_.back().text;
+            if (!isPrefix(head, stable)) return true;
+            return stable.size() - head.size() >= kMinChunkChars;
+        });
+        if (stopping_) {
+            break;
+        }
+
+        rewindLocked(stable);
+        if (isPrefix(checkpoints_.back().text, stable) && stable.size() - checkpoints_.back().text.size() >= kMinChunkChars &&
+            !extendLocked(chunkEnd(checkpoints_.back().text, stable), lock)) {
+            // A failing engine would fail the same way on every keystroke;
+            // stop prefilling and let commit rewind and add the rest.
+            break;
+        }
+    }
+
+    workerExited_ = true;
+    lock.unlock();
+    ThreadPlacement::shared().releaseCurrentThread();
+}
+
+void DraftPrefill::rewindLocked(const std::string& target) {
+    while (checkpoints_.size() > 1 && !isPrefix(checkpoints_.back().text, target)) {
+        ops_.release(checkpoints_.back().session);
+        checkpoints_.pop_back();
+        ++stats_.rewinds;
+    }
+}
+
+bool DraftPrefill::extendLocked(const std::string& target, std::unique_lock<std::mutex>& lock) {
+    // Only the worker mutates checkpoints until it is joined, so the head
+    // stays valid with the lock released for the slow part.
+    Checkpoint head = checkpoints_.back();
+    std::string delta = target.substr(head.text.size());
+
+    lock.unlock();
+    void* next = ops_.clone(head.session);
+    bool ok = next && ops_.addQueryChunk(next, delta);
+    lock.lock();
+
+    if (!ok) {
+        if (next) ops_.release(next);
+        return false;
+    }
+
+    checkpoints_.push_back(Checkpoint{next, target});
+    ++stats_.chunks;
+
+    // Keep the root and the most recent checkpoints.
+    if (checkpoints_.size() > maxCheckpoints_ + 1) {
+        ops_.release(checkpoints_[1].session);
+        checkpoints_.erase(checkpoints_.begin() + 1);
+    }
+
+    return true;
+}
+
+} // namespace mediapipe_llm
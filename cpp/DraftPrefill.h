@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mediapipe_llm {
+
+// Session operations a draft needs, kept abstract so the prefix bookkeeping
+// doesn't depend on the engine API. Sessions are opaque handles.
+struct DraftSessionOps {
+    std::function<void*(void* session)> clone;  // nullptr on failure
+    std::function<bool(void* session, const std::string& text)> addQueryChunk;
+    std::function<void(void* session)> release;
+};
+
+struct DraftPrefillStats {
+    // Query text already prefilled; after commit, the part that was
+    // prefilled before the send.
+    size_t prefilledChars = 0;
+    size_t chunks = 0;
+    size_t rewinds = 0;
+};
+
+// Prefills the query on a background thread while the user is still typing.
+//
+// Only the stable part of the draft is prefilled: everything before the word
+// being typed, cut at whitespace so the tokens match those of the final
+// text. Each prefilled chunk lands on a fresh clone, and the clones are kept
+// as checkpoints; an edit that invalidates recent chunks rewinds to the
+// longest checkpoint that is still a prefix instead of starting over. On
+// commit only the remaining tail is added.
+class DraftPrefill {
+public:
+    // Clones beyond the root each hold their own copy of the context, so
+    // only a few recent ones are kept.
+    static constexpr size_t kDefaultMaxCheckpoints = 3;
+    // Below this the per-chunk overhead outweighs the prefill it hides.
+    static constexpr size_t kMinChunkChars = 16;
+    // Longer stable text is prefilled in several chunks, so stopping the
+    // worker never waits on more than one short chunk.
+    static constexpr size_t kMaxChunkChars = 128;
+
+    DraftPrefill(void* baseSession, DraftSessionOps ops, size_t maxCheckpoints = kDefaultMaxCheckpoints);
+    ~DraftPrefill();
+
+    DraftPrefill(const DraftPrefill&) = delete;
+    DraftPrefill& operator=(const DraftPrefill&) = delete;
+
+    // False if the base session could not be cloned; updates are then ignored.
+    bool valid() const { return valid_; }
+
+    // Records the latest draft text and returns immediately.
+    void update(const std::string& draft);
+
+    // Waits for in-flight prefill, rewinds to the longest prefix of
+    // `finalText`, adds the rest and hands the session to the caller.
+    // Returns nullptr and fills `error` on failure. The draft is spent
+    // afterwards either way.
+    void* commit(const std::string& finalText, std::string& error);
+
+    // Asks the worker to stop after the chunk in flight and returns at once.
+    // Destroying the draft waits for the worker; once isStopped() it won't.
+    void cancel();
+    bool isStopped() const;
+
+    DraftPrefillStats stats() const;
+
+    static std::string stablePrefix(const std::string& draft);
+
+private:
+    struct Checkpoint {
+        void* session;
+        std::string text;
+    };
+
+    void run();
+    void rewindLocked(const std::string& target);
+    bool extendLocked(const std::string& target, std::unique_lock<std::mutex>& lock);
+
+    const DraftSessionOps ops_;
+    const size_t maxCheckpoints_;
+    bool valid_ = false;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    // checkpoints_[0] is the untouched root clone; texts grow with the index.
+    std::vector<Checkpoint> checkpoints_;
+    std::string target_;
+    bool stopping_ = false;
+    bool workerExited_ = false;
+    DraftPrefillStats stats_;
+    std::thread worker_;
+};
+
+} // namespace mediapipe_llm
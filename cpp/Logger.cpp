@@ -0,0 +1,365 @@
+#include "Logger.h"
+#include "ThreadPlacement.h"
+#include <algorithm>
+
+#if defined(__ANDROID__)
+#include <android/log.h>
+#elif defined(__APPLE__)
+#include <os/log.h>
+#endif
+
+namespace mediapipe_llm {
+
+namespace {
+
+struct EventInfo {
+    const char* name;
+    const char* fields[kMaxLogFields];
+};
+
+// Indexed by LogEvent; keep in the same order.
+const EventInfo kEventInfo[] = {
+    {"jni_load", {}},
+    {"engine_create", {"path_bytes", "elapsed_ms", "backend"}},
+    {"engine_create_failed", {"elapsed_ms"}},
+    {"engine_delete", {}},
+    {"engine_delete_failed", {}},
+    {"session_create", {"elapsed_ms", "lora"}},
+    {"session_create_failed", {}},
+    {"generate", {"prompt_bytes"}},
+    {"generate_done", {"response_bytes", "elapsed_ms"}},
+    {"generate_failed", {"elapsed_ms"}},
+    {"predict_async", {}},
+    {"stream_finished", {"bytes", "notifications", "backpressure_waits", "failed"}},
+    {"nbest_start", {"candidates", "stop_after", "prompt_bytes"}},
+    {"draft_commit", {"prefilled_chars", "tail_chars", "chunks", "rewinds"}},
+    {"lora_swap", {"adapter_bytes", "elapsed_ms"}},
+    {"autotune_done", {"candidates", "backend", "activation", "cached"}},
+    {"model_inspect_failed", {}},
+    {"image_loader_setup", {}},
+    {"image_load", {"uri_bytes"}},
+    {"image_source_unsupported", {}},
+};
+
+static_assert(sizeof(kEventInfo) / sizeof(kEventInfo[0]) == static_cast<size_t>(LogEvent::Count),
+              "kEventInfo must have one entry per LogEvent");
+static_assert((Logger::kRingCapacity & (Logger::kRingCapacity - 1)) == 0,
+              "kRingCapacity must be a power of two");
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+char levelChar(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return 'D';
+        case LogLevel::Info: return 'I';
+        case LogLevel::Warn: return 'W';
+        case LogLevel::Error: return 'E';
+    }
+    return '?';
+}
+
+#if defined(__ANDROID__)
+int androidPriority(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return ANDROID_LOG_DEBUG;
+        case LogLevel::Info: return ANDROID_LOG_INFO;
+        case LogLevel::Warn: return ANDROID_LOG_WARN;
+        case LogLevel::Error: return ANDROID_LOG_ERROR;
+    }
+    return ANDROID_LOG_INFO;
+}
+#elif defined(__APPLE__)
+os_log_type_t appleLogType(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return OS_LOG_TYPE_DEBUG;
+        case LogLevel::Info: return OS_LOG_TYPE_INFO;
+        case LogLevel::Warn: return OS_LOG_TYPE_DEFAULT;
+        case LogLevel::Error: return OS_LOG_TYPE_ERROR;
+    }
+    return OS_LOG_TYPE_DEFAULT;
+}
+#endif
+
+} // namespace
+
+const char* logEventName(LogEvent event) {
+    size_t index = static_cast<size_t>(event);
+    return index < static_cast<size_t>(LogEvent::Count) ? kEventInfo[index].name : "unknown";
+}
+
+// Written by its owning thread only, read by whoever holds drainMutex_.
+// head and tail sit on separate cache lines so the two sides don't
+// contend on every record.
+struct Logger::ThreadRing {
+    explicit ThreadRing(uint64_t tid) : threadId(tid) {}
+
+    const uint64_t threadId;
+    alignas(64) std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> dropped{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    std::atomic<bool> retired{false};
+    LogRecord slots[kRingCapacity];
+};
+
+Logger& Logger::shared() {
+    static Logger* logger = new Logger();
+    return *logger;
+}
+
+Logger::Logger() : startNs_(nowNs()) {
+    history_.reserve(kHistoryCapacity);
+}
+
+void Logger::append(LogRecord& rec) {
+    ThreadRing* ring = ringForCurrentThread();
+    if (!ring) {
+        return;
+    }
+
+    rec.timestampNs = nowNs();
+
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= kRingCapacity) {
+        // Single writer, so a plain increment is enough.
+        ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->slots[head & (kRingCapacity - 1)] = rec;
+    // Sequentially consistent with the drain thread's check of drainIdle_
+    // and the heads, so either it sees this record or we see it idle.
+    ring->head.store(head + 1, std::memory_order_seq_cst);
+
+    if (drainIdle_.load(std::memory_order_seq_cst) && drainIdle_.exchange(false)) {
+        wakeDrain();
+    } else if (head + 1 - ring->tail.load(std::memory_order_relaxed) >= kDrainSoonFill &&
+               !drainSoon_.load(std::memory_order_relaxed) && !drainSoon_.exchange(true)) {
+        wakeDrain();
+    }
+}
+
+void Logger::wakeDrain() {
+    // Taking the mutex orders this with the drain thread's predicate check,
+    // so the wake-up can't slip in before it starts waiting.
+    { std::lock_guard<std::mutex> lock(drainMutex_); }
+    drainWake_.notify_one();
+}
+
+bool Logger::ringsEmpty() {
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    for (const auto& ring : rings_) {
+        if (ring->head.load(std::memory_order_seq_cst) != ring->tail.load(std::memory_order_relaxed)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Logger::ThreadRing* Logger::ringForCurrentThread() {
+    // The ring outlives its thread; the drain frees it once it is retired
+    // and empty. Records made after the handle is gone are dropped.
+    static thread_local ThreadRing* current = nullptr;
+    static thread_local bool exited = false;
+    struct Handle {
+        std::shared_ptr<ThreadRing> ring;
+        ~Handle() {
+            if (ring) {
+                ring->retired.store(true, std::memory_order_release);
+                // An idle drain would otherwise keep counting the ring.
+                Logger& logger = Logger::shared();
+                if (logger.drainIdle_.exchange(false)) {
+                    logger.wakeDrain();
+                }
+            }
+            current = nullptr;
+            exited = true;
+        }
+    };
+    static thread_local Handle handle;
+
+    if (current || exited) {
+        return current;
+    }
+
+    handle.ring = std::make_shared<ThreadRing>(currentThreadId());
+    current = handle.ring.get();
+
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    rings_.push_back(handle.ring);
+    if (!drainThread_.joinable()) {
+        drainThread_ = std::thread(&Logger::drainLoop, this);
+    }
+
+    return current;
+}
+
+void Logger::drainLoop() {
+    // Not placed: it is not inference work and would skew the role stats.
+    std::unique_lock<std::mutex> lock(drainMutex_);
+    while (true) {
+        drainIdle_.store(true, std::memory_order_seq_cst);
+        if (ringsEmpty()) {
+            drainWake_.wait(lock, [this] { return !drainIdle_.load(); });
+        }
+        drainIdle_.store(false);
+
+        // Let records batch up, unless a ring is filling faster than that.
+        drainWake_.wait_for(lock, kDrainInterval, [this] { return drainSoon_.load(); });
+        drainSoon_.store(false);
+        drainLocked();
+    }
+}
+
+void Logger::drainLocked() {
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        rings = rings_;
+    }
+
+    std::vector<DrainedRecord> batch;
+    for (auto& ring : rings) {
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (uint64_t i = tail; i != head; ++i) {
+            batch.push_back(DrainedRecord{ring->slots[i & (kRingCapacity - 1)], ring->threadId});
+        }
+        ring->tail.store(head, std::memory_order_release);
+    }
+
+    std::stable_sort(batch.begin(), batch.end(), [](const DrainedRecord& a, const DrainedRecord& b) {
+        return a.record.timestampNs < b.record.timestampNs;
+    });
+
+    for (const auto& drained : batch) {
+        if (history_.size() < kHistoryCapacity) {
+            history_.push_back(drained);
+        } else {
+            history_[historyNext_] = drained;
+        }
+        historyNext_ = (historyNext_ + 1) % kHistoryCapacity;
+        writeLocked(drained);
+    }
+    if (file_ && !batch.empty()) {
+        fflush(file_);
+    }
+
+    // Rings of exited threads are final once retired; free them when empty.
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [this](const std::shared_ptr<ThreadRing>& ring) {
+        if (!ring->retired.load(std::memory_order_acquire) ||
+            ring->head.load(std::memory_order_acquire) != ring->tail.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        retiredRecorded_ += ring->head.load(std::memory_order_relaxed);
+        retiredDropped_ += ring->dropped.load(std::memory_order_relaxed);
+        return true;
+    }), rings_.end());
+}
+
+void Logger::writeLocked(const DrainedRecord& drained) {
+    switch (sink_) {
+        case LogSink::None:
+            return;
+        case LogSink::File:
+            if (file_) {
+                fprintf(file_, "%s\n", format(drained).c_str());
+            }
+            return;
+        case LogSink::Platform: {
+            std::string line = format(drained);
+#if defined(__ANDROID__)
+            __android_log_write(androidPriority(drained.record.level), "MediapipeLlm", line.c_str());
+#elif defined(__APPLE__)
+            static os_log_t log = os_log_create("com.reactnativemediapipellm", "native");
+            os_log_with_type(log, appleLogType(drained.record.level), "%{public}s", line.c_str());
+#else
+            fprintf(stderr, "%s\n", line.c_str());
+#endif
+            return;
+        }
+    }
+}
+
+std::string Logger::format(const DrainedRecord& drained) const {
+    const LogRecord& rec = drained.record;
+    size_t index = static_cast<size_t>(rec.event);
+    const EventInfo* info = index < static_cast<size_t>(LogEvent::Count) ? &kEventInfo[index] : nullptr;
+
+    char buffer[256];
+    int length = snprintf(buffer, sizeof(buffer), "%12.6f %c %llu %s",
+        (rec.timestampNs - startNs_) / 1e9, levelChar(rec.level),
+        static_cast<unsigned long long>(drained.threadId), info ? info->name : "unknown");
+
+    for (size_t i = 0; i < rec.fieldCount && i < kMaxLogFields; ++i) {
+        if (length < 0 || static_cast<size_t>(length) >= sizeof(buffer)) {
+            break;
+        }
+        const char* label = info && info->fields[i] ? info->fields[i] : "field";
+        length += snprintf(buffer + length, sizeof(buffer) - length, " %s=%lld",
+            label, static_cast<long long>(rec.fields[i]));
+    }
+
+    return std::string(buffer, std::min(static_cast<size_t>(std::max(length, 0)), sizeof(buffer) - 1));
+}
+
+bool Logger::setSink(LogSink sink, const std::string& path) {
+    std::lock_guard<std::mutex> lock(drainMutex_);
+
+    FILE* file = nullptr;
+    if (sink == LogSink::File) {
+        file = fopen(path.c_str(), "a");
+        if (!file) {
+            return false;
+        }
+    }
+
+    // Whatever is pending still goes to the old sink.
+    drainLocked();
+
+    if (file_) {
+        fclose(file_);
+    }
+    file_ = file;
+    sink_ = sink;
+
+    return true;
+}
+
+std::string Logger::dump(size_t maxRecords) {
+    std::lock_guard<std::mutex> lock(drainMutex_);
+    drainLocked();
+
+    size_t count = std::min(maxRecords, history_.size());
+    size_t oldest = history_.size() < kHistoryCapacity ? 0 : historyNext_;
+    size_t first = oldest + (history_.size() - count);
+
+    std::string out;
+    for (size_t i = 0; i < count; ++i) {
+        out += format(history_[(first + i) % history_.size()]);
+        out += '\n';
+    }
+
+    return out;
+}
+
+LoggerStats Logger::stats() {
+    std::lock_guard<std::mutex> drainLock(drainMutex_);
+    std::lock_guard<std::mutex> ringsLock(ringsMutex_);
+
+    LoggerStats stats;
+    stats.recorded = retiredRecorded_;
+    stats.dropped = retiredDropped_;
+    for (const auto& ring : rings_) {
+        stats.recorded += ring->head.load(std::memory_order_acquire);
+        stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    stats.threads = rings_.size();
+
+    return stats;
+}
+
+} // namespace mediapipe_llm
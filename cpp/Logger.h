@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records below this level compile away; their arguments are never evaluated.
+// 0 = debug, 1 = info, 2 = warn, 3 = error, 4 = off.
+#ifndef MEDIAPIPE_LLM_LOG_LEVEL
+  #ifdef NDEBUG
+    #define MEDIAPIPE_LLM_LOG_LEVEL 1
+  #else
+    #define MEDIAPIPE_LLM_LOG_LEVEL 0
+  #endif
+#endif
+
+namespace mediapipe_llm {
+
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3,
+};
+
+// Every log site has its own event. Records carry only the event and up to
+// kMaxLogFields integers; names and field labels are attached at drain time.
+// Never log user content: sizes and durations only.
+enum class LogEvent : uint16_t {
+    JniLoad,
+    EngineCreate,
+    EngineCreateFailed,
+    EngineDelete,
+    EngineDeleteFailed,
+    SessionCreate,
+    SessionCreateFailed,
+    Generate,
+    GenerateDone,
+    GenerateFailed,
+    PredictAsync,
+    StreamFinished,
+    NBestStart,
+    DraftCommit,
+    LoraSwap,
+    AutotuneDone,
+    ModelInspectFailed,
+    ImageLoaderSetup,
+    ImageLoad,
+    ImageSourceUnsupported,
+    Count,
+};
+
+constexpr size_t kMaxLogFields = 4;
+
+struct LogRecord {
+    uint64_t timestampNs = 0;
+    LogEvent event = LogEvent::Count;
+    LogLevel level = LogLevel::Info;
+    uint8_t fieldCount = 0;
+    int64_t fields[kMaxLogFields] = {};
+};
+
+enum class LogSink {
+    None,      // keep history for dump() only
+    Platform,  // logcat on Android, os_log on Apple, stderr elsewhere
+    File,
+};
+
+struct LoggerStats {
+    uint64_t recorded = 0;
+    uint64_t dropped = 0;  // ring full when the record was made
+    size_t threads = 0;
+};
+
+const char* logEventName(LogEvent event);
+
+// Binary event log. Each thread writes into its own single-producer ring,
+// so the hot path is a clock read, a few stores and a release; nothing is
+// formatted or written out there. A drain thread empties the rings into a
+// history buffer and the configured sink: kDrainInterval after the first
+// record it finds, or sooner once a ring is kDrainSoonFill full. With every
+// ring empty it sleeps until the next record. A full ring drops the record
+// and counts it rather than blocking the caller.
+class Logger {
+public:
+    static constexpr size_t kRingCapacity = 1024;  // per thread, power of two
+    static constexpr size_t kDrainSoonFill = kRingCapacity / 2;
+    static constexpr size_t kHistoryCapacity = 4096;
+    static constexpr auto kDrainInterval = std::chrono::milliseconds(250);
+
+    // Never destroyed, so threads may log during static destruction.
+    static Logger& shared();
+
+    template <typename... Fields>
+    void record(LogLevel level, LogEvent event, Fields... fields) {
+        static_assert(sizeof...(Fields) <= kMaxLogFields, "too many log fields");
+        LogRecord rec;
+        rec.level = level;
+        rec.event = event;
+        rec.fieldCount = static_cast<uint8_t>(sizeof...(Fields));
+        int64_t values[] = {0, static_cast<int64_t>(fields)...};
+        for (size_t i = 0; i < sizeof...(Fields); ++i) {
+            rec.fields[i] = values[i + 1];
+        }
+        append(rec);
+    }
+
+    // Returns false if the file sink could not be opened; the sink is then
+    // left unchanged.
+    bool setSink(LogSink sink, const std::string& path = "");
+
+    // Drains every ring and formats the most recent `maxRecords` records,
+    // oldest first, one per line.
+    std::string dump(size_t maxRecords = kHistoryCapacity);
+
+    LoggerStats stats();
+
+private:
+    struct ThreadRing;
+    struct DrainedRecord {
+        LogRecord record;
+        uint64_t threadId;
+    };
+
+    Logger();
+
+    void append(LogRecord& rec);
+    ThreadRing* ringForCurrentThread();
+    void drainLoop();
+    void wakeDrain();
+    bool ringsEmpty();
+    void drainLocked();
+    void writeLocked(const DrainedRecord& drained);
+    std::string format(const DrainedRecord& drained) const;
+
+    const uint64_t startNs_;
+
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+    std::thread drainThread_;
+
+    // Guards the consumer side of every ring, the history and the sink.
+    std::mutex drainMutex_;
+    std::condition_variable drainWake_;
+    // Set while the drain thread sleeps with nothing to drain; the first
+    // record to clear it wakes the thread.
+    std::atomic<bool> drainIdle_{false};
+    // Set once a ring passes kDrainSoonFill, to drain before the interval ends.
+    std::atomic<bool> drainSoon_{false};
+    std::vector<DrainedRecord> history_;
+    size_t historyNext_ = 0;
+    uint64_t retiredRecorded_ = 0;
+    uint64_t retiredDropped_ = 0;
+    LogSink sink_ = LogSink::Platform;
+    FILE* file_ = nullptr;
+};
+
+} // namespace mediapipe_llm
+
+#define MEDIAPIPE_LLM_LOG(level, event, ...) \
+    ::mediapipe_llm::Logger::shared().record(::mediapipe_llm::LogLevel::level, ::mediapipe_llm::LogEvent::event, ##__VA_ARGS__)
+
+// Still type-checked, and keeps arguments "used", but never runs.
+#define MEDIAPIPE_LLM_LOG_DISABLED(level, event, ...) \
+    do { if (false) MEDIAPIPE_LLM_LOG(level, event, ##__VA_ARGS__); } while (0)
+
+#if MEDIAPIPE_LLM_LOG_LEVEL <= 0
+  #define LLM_LOGD(event, ...) MEDIAPIPE_LLM_LOG(Debug, event, ##__VA_ARGS__)
+#else
+  #define LLM_LOGD(event, ...) MEDIAPIPE_LLM_LOG_DISABLED(Debug, event, ##__VA_ARGS__)
+#endif
+
+#if MEDIAPIPE_LLM_LOG_LEVEL <= 1
+  #define LLM_LOGI(event, ...) MEDIAPIPE_LLM_LOG(Info, event, ##__VA_ARGS__)
+#else
+  #define LLM_LOGI(event, ...) MEDIAPIPE_LLM_LOG_DISABLED(Info, event, ##__VA_ARGS__)
+#endif
+
+#if MEDIAPIPE_LLM_LOG_LEVEL <= 2
+  #define LLM_LOGW(event, ...) MEDIAPIPE_LLM_LOG(Warn, event, ##__VA_ARGS__)
+#else
+  #define LLM_LOGW(event, ...) MEDIAPIPE_LLM_LOG_DISABLED(Warn, event, ##__VA_ARGS__)
+#endif
+
+#if MEDIAPIPE_LLM_LOG_LEVEL <= 3
+  #define LLM_LOGE(event, ...) MEDIAPIPE_LLM_LOG(Error, event, ##__VA_ARGS__)
+#else
+  #define LLM_LOGE(event, ...) MEDIAPIPE_LLM_LOG_DISABLED(Error, event, ##__VA_ARGS__)
+#endif
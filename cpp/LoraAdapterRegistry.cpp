@@ -0,0 +1,90 @@
+#include "LoraAdapterRegistry.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mediapipe_llm {
+
+namespace {
+
+int64_t mtimeNs(const struct stat& st) {
+#if defined(__APPLE__)
+    return static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
+
+bool statAdapter(const std::string& path, LoraAdapter& adapter, std::string& error) {
+    // Opened rather than just stat'ed so an unreadable file fails here with
+    // a clear message instead of inside the engine.
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open LoRA adapter " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    struct stat st = {};
+    bool ok = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0;
+    close(fd);
+
+    if (!ok) {
+        error = "LoRA adapter is empty or not a regular file: " + path;
+        return false;
+    }
+
+    adapter.path = path;
+    adapter.sizeBytes = static_cast<size_t>(st.st_size);
+    adapter.device = st.st_dev;
+    adapter.inode = st.st_ino;
+    adapter.mtimeNs = mtimeNs(st);
+    return true;
+}
+
+} // namespace
+
+std::shared_ptr<LoraAdapter> LoraAdapterRegistry::acquire(const std::string& path, std::string& error) {
+    LoraAdapter current;
+    if (!statAdapter(path, current, error)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = adapters_.find(path);
+    if (it != adapters_.end()) {
+        auto existing = it->second.lock();
+        if (existing && existing->device == current.device && existing->inode == current.inode &&
+            existing->sizeBytes == current.sizeBytes && existing->mtimeNs == current.mtimeNs) {
+            return existing;
+        }
+    }
+
+    auto adapter = std::make_shared<LoraAdapter>(std::move(current));
+    adapters_[path] = adapter;
+
+    // Drop entries whose sessions are all gone.
+    for (auto entry = adapters_.begin(); entry != adapters_.end();) {
+        entry = entry->second.expired() ? adapters_.erase(entry) : std::next(entry);
+    }
+
+    return adapter;
+}
+
+LoraAdapterStats LoraAdapterRegistry::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    LoraAdapterStats stats;
+    for (const auto& entry : adapters_) {
+        if (auto adapter = entry.second.lock()) {
+            ++stats.inUse;
+            stats.inUseBytes += adapter->sizeBytes;
+        }
+    }
+    return stats;
+}
+
+} // namespace mediapipe_llm
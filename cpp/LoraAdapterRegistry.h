@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <sys/types.h>
+
+namespace mediapipe_llm {
+
+// A LoRA adapter file that one or more sessions were created with. The C API
+// only takes `lora_path`; the engine reads the file itself when a session is
+// created, and this process never holds the weights. The handle keeps the
+// path string alive for the session's config and identifies the file
+// version the session saw.
+struct LoraAdapter {
+    std::string path;
+    size_t sizeBytes = 0;
+    dev_t device = 0;
+    ino_t inode = 0;
+    int64_t mtimeNs = 0;
+};
+
+struct LoraAdapterStats {
+    size_t inUse = 0;       // distinct adapters held by at least one session
+    size_t inUseBytes = 0;  // on-disk size of those adapters; held by the engine, not here
+};
+
+// Path/refcount registry of the adapters sessions use. Sessions asking for
+// the same unchanged file share one handle, which shows which adapters are
+// live; a replaced file gets a new handle. Entries go away with the last
+// session holding them. Nothing is cached: the engine reads the file again
+// for every session it creates.
+class LoraAdapterRegistry {
+public:
+    // Returns the handle for `path`, checking that the file exists and is a
+    // readable, non-empty regular file. Returns nullptr and fills `error`
+    // otherwise.
+    std::shared_ptr<LoraAdapter> acquire(const std::string& path, std::string& error);
+
+    LoraAdapterStats stats() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::weak_ptr<LoraAdapter>> adapters_;
+};
+
+} // namespace mediapipe_llm
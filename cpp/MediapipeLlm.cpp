@@ -1,5 +1,12 @@
 #include "MediapipeLlm.h"
 #include "JSI_Helpers.h"
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <thread>
@@ -19,8 +26,16 @@ MediapipeLlm::MediapipeLlm() {
 
 MediapipeLlm::~MediapipeLlm() {
 #if HAS_JSI
+    std::vector<std::string> engineIds;
+    for (const auto& entry : engines_) {
+        engineIds.push_back(entry.first);
+    }
+    for (const auto& engineId : engineIds) {
+        destroyEngine(engineId);
+    }
+    drafts_.clear();
+    retiredDrafts_.clear();
     sessions_.clear();
-    engines_.clear();
 #endif
 }
 
@@ -64,6 +79,24 @@ void MediapipeLlm::install(Runtime& runtime) {
                 return addQueryChunk(runtime, thisValue, arguments, count);
             }));
     
+    mediapipeLlm.setProperty(runtime, "updateDraft",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "updateDraft"), 2,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return updateDraft(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "commitDraft",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "commitDraft"), 2,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return commitDraft(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "discardDraft",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "discardDraft"), 1,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return discardDraft(runtime, thisValue, arguments, count);
+            }));
+    
     mediapipeLlm.setProperty(runtime, "addImage",
         Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "addImage"), 2,
             [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
@@ -83,11 +116,29 @@ void MediapipeLlm::install(Runtime& runtime) {
             }));
     
     mediapipeLlm.setProperty(runtime, "predictAsync",
-        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "predictAsync"), 2,
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "predictAsync"), 3,
             [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
                 return predictAsync(runtime, thisValue, arguments, count);
             }));
     
+    mediapipeLlm.setProperty(runtime, "predictNBest",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "predictNBest"), 3,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return predictNBest(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "readStream",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "readStream"), 1,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return readStream(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "releaseNBest",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "releaseNBest"), 1,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return releaseNBest(runtime, thisValue, arguments, count);
+            }));
+    
     mediapipeLlm.setProperty(runtime, "cloneSession",
         Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "cloneSession"), 1,
             [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
@@ -106,6 +157,60 @@ void MediapipeLlm::install(Runtime& runtime) {
                 return cancelPendingProcess(runtime, thisValue, arguments, count);
             }));
     
+    mediapipeLlm.setProperty(runtime, "swapLoraAdapter",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "swapLoraAdapter"), 2,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return swapLoraAdapter(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "getLoraAdapterStats",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "getLoraAdapterStats"), 0,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return getLoraAdapterStats(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "inspectModel",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "inspectModel"), 1,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return inspectModel(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "autotune",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "autotune"), 2,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return autotune(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "setThreadPolicy",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "setThreadPolicy"), 1,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return setThreadPolicy(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "getThreadStats",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "getThreadStats"), 0,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return getThreadStats(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "dumpLogs",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "dumpLogs"), 1,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return dumpLogs(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "setLogSink",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "setLogSink"), 2,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return setLogSink(runtime, thisValue, arguments, count);
+            }));
+    
+    mediapipeLlm.setProperty(runtime, "getLogStats",
+        Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "getLogStats"), 0,
+            [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
+                return getLogStats(runtime, thisValue, arguments, count);
+            }));
+    
     mediapipeLlm.setProperty(runtime, "multiply",
         Function::createFromHostFunction(runtime, PropNameID::forAscii(runtime, "multiply"), 2,
             [this](Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) -> Value {
@@ -117,6 +222,227 @@ void MediapipeLlm::install(Runtime& runtime) {
 #endif
 
 #if HAS_JSI
+namespace {
+
+// Enough decode steps to get past warm-up without making first run painful;
+// every candidate costs a full engine load on top of this.
+constexpr size_t kBenchmarkDecodeTokens = 32;
+constexpr auto kBenchmarkCancelTimeout = std::chrono::seconds(10);
+// RSS is sampled this often while the benchmark runs; engine working
+// buffers are only resident while it does.
+constexpr auto kBenchmarkMemorySampleInterval = std::chrono::milliseconds(20);
+const char* kBenchmarkSentence =
+    "The river ran past the old mill, and the miller counted sacks of grain while the wheel turned. ";
+
+// Shared between the benchmark and the engine's callback thread, which holds
+// its own reference until the final response; a cancel that never lands
+// then can't leave the callback writing into a dead frame.
+struct BenchmarkState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::chrono::steady_clock::time_point firstChunk;
+    std::chrono::steady_clock::time_point lastChunk;
+    std::string firstText;
+    std::string text;
+    size_t chunks = 0;
+    bool done = false;
+    std::string error;
+};
+
+void onBenchmarkResponse(void* context, LlmResponseContext* response, const char* error) {
+    auto* holder = static_cast<std::shared_ptr<BenchmarkState>*>(context);
+    auto state = *holder;
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (error) {
+            state->error = error;
+            finished = true;
+        } else if (response) {
+            if (response->response_count > 0 && response->response_array[0]) {
+                auto now = std::chrono::steady_clock::now();
+                if (state->chunks++ == 0) {
+                    state->firstChunk = now;
+                    state->firstText = response->response_array[0];
+                }
+                state->lastChunk = now;
+                state->text += response->response_array[0];
+            }
+            finished = response->done;
+        }
+        state->done = state->done || finished;
+    }
+    if (response) {
+        LlmInferenceEngine_CloseResponseContext(response);
+    }
+    if (finished) {
+        delete holder;
+    }
+    state->cv.notify_all();
+}
+
+// One search at a time: each candidate loads a full engine.
+std::atomic<bool> autotuneRunning{false};
+
+// How long deleting a session waits for a cancelled request to wind down.
+constexpr auto kStopRequestTimeout = std::chrono::seconds(5);
+
+// Most smart-reply style features want 3-5; more than this is better served
+// by separate requests than by holding that many KV caches at once.
+constexpr size_t kMaxNBestCandidates = 8;
+
+// Owned by the engine's callback thread from PredictAsync until the final
+// (done or error) response arrives.
+struct AsyncRequest {
+    std::shared_ptr<TokenStream> stream;
+    std::shared_ptr<NBestGroup> group;
+    size_t index = 0;
+    ThreadRole role = ThreadRole::Decode;
+};
+
+// The stream options shared by predictAsync and predictNBest, checked here
+// so a bad value from JS can't stall or flood the decode thread.
+TokenStreamOptions streamOptions(Runtime& runtime, const Object& options) {
+    TokenStreamOptions result;
+    double notifyIntervalMs = JSI_Helpers::getOptionalNumber(
+        runtime, options, "notifyIntervalMs", static_cast<double>(result.notifyInterval.count()));
+    double highWaterBytes = JSI_Helpers::getOptionalNumber(
+        runtime, options, "highWaterBytes", static_cast<double>(result.highWaterBytes));
+    if (!(notifyIntervalMs >= 0) || notifyIntervalMs > 60000) {
+        throw JSError(runtime, "notifyIntervalMs must be between 0 and 60000");
+    }
+    if (!(highWaterBytes >= 1) || highWaterBytes > 1 << 30) {
+        throw JSError(runtime, "highWaterBytes must be between 1 and 1 GiB");
+    }
+    result.notifyInterval = std::chrono::milliseconds(static_cast<long>(notifyIntervalMs));
+    result.highWaterBytes = static_cast<size_t>(highWaterBytes);
+    return result;
+}
+
+// The `priority` request option: "interactive" (the default) decodes under
+// the decode policy, "background" under the background one.
+ThreadRole requestRole(Runtime& runtime, const Object& options) {
+    std::string priority = JSI_Helpers::getOptionalString(runtime, options, "priority");
+    if (priority.empty() || priority == "interactive") {
+        return ThreadRole::Decode;
+    }
+    if (priority == "background") {
+        return ThreadRole::Background;
+    }
+    throw JSError(runtime, "priority must be \"interactive\" or \"background\"");
+}
+
+void onCandidateDone(NBestGroup* group, size_t index) {
+    size_t completed = group->completed.fetch_add(1) + 1;
+    if (completed != group->stopAfter) {
+        return;
+    }
+    
+    // Enough candidates are in; stop the stragglers. Their streams are
+    // cancelled first so none of them stays parked on backpressure.
+    for (size_t i = 0; i < group->sessions.size(); ++i) {
+        if (i == index || group->streams[i]->isFinished()) {
+            continue;
+        }
+        group->streams[i]->cancel();
+        char* error_msg = nullptr;
+        LlmInferenceEngine_Session_PendingProcessCancellation(group->sessions[i], &error_msg);
+        if (error_msg) free(error_msg);
+    }
+}
+
+void onAsyncResponse(void* context, LlmResponseContext* response, const char* error) {
+    auto* request = static_cast<AsyncRequest*>(context);
+    
+    // The engine calls back on its own thread; place it under the request's
+    // role the first time it hands us a token and release it when the
+    // request ends, so its CPU time is billed while the thread is still
+    // alive. See ThreadPlacement.h for what this does not reach.
+    static thread_local bool placed = false;
+    if (!placed) {
+        ThreadPlacement::shared().placeCurrentThread(request->role);
+        placed = true;
+    }
+    
+    bool done = error != nullptr;
+    if (response) {
+        if (!error && response->response_count > 0 && response->response_array[0]) {
+            request->stream->append(response->response_array[0], strlen(response->response_array[0]));
+        }
+        done = done || response->done;
+        LlmInferenceEngine_CloseResponseContext(response);
+    }
+    
+    if (done) {
+        // The group must be updated before the stream finishes: once all
+        // streams report finished, JS is free to destroy the group. The
+        // reference is dropped here too, so the candidate sessions are never
+        // deleted from one of their own callbacks.
+        if (request->group) {
+            onCandidateDone(request->group.get(), request->index);
+            request->group.reset();
+        }
+        auto stats = request->stream->stats();
+        LLM_LOGI(StreamFinished, stats.bytesWritten, stats.notifications, stats.backpressureWaits, error ? 1 : 0);
+        request->stream->finish(error ? error : "");
+        delete request;
+        ThreadPlacement::shared().releaseCurrentThread();
+        placed = false;
+    }
+}
+
+class StringBuffer : public MutableBuffer {
+public:
+    explicit StringBuffer(std::string data) : data_(std::move(data)) {}
+    size_t size() const override { return data_.size(); }
+    uint8_t* data() override { return reinterpret_cast<uint8_t*>(&data_[0]); }
+    
+private:
+    std::string data_;
+};
+
+DraftSessionOps draftSessionOps() {
+    DraftSessionOps ops;
+    ops.clone = [](void* session) -> void* {
+        LlmInferenceEngine_Session* clone = nullptr;
+        char* error_msg = nullptr;
+        int result = LlmInferenceEngine_Session_Clone(static_cast<LlmInferenceEngine_Session*>(session), &clone, &error_msg);
+        if (error_msg) free(error_msg);
+        return result == 0 ? clone : nullptr;
+    };
+    ops.addQueryChunk = [](void* session, const std::string& text) {
+        char* error_msg = nullptr;
+        int result = LlmInferenceEngine_Session_AddQueryChunk(static_cast<LlmInferenceEngine_Session*>(session), text.c_str(), &error_msg);
+        if (error_msg) free(error_msg);
+        return result == 0;
+    };
+    ops.release = [](void* session) {
+        LlmInferenceEngine_Session_Delete(static_cast<LlmInferenceEngine_Session*>(session));
+    };
+    return ops;
+}
+
+Object createDraftStatsObject(Runtime& runtime, const DraftPrefillStats& stats) {
+    auto statsObj = Object(runtime);
+    statsObj.setProperty(runtime, "prefilledChars", Value(static_cast<double>(stats.prefilledChars)));
+    statsObj.setProperty(runtime, "chunks", Value(static_cast<double>(stats.chunks)));
+    statsObj.setProperty(runtime, "rewinds", Value(static_cast<double>(stats.rewinds)));
+    return statsObj;
+}
+
+std::vector<AutotuneCandidate> defaultAutotuneCandidates() {
+    return {
+        {kLlmPreferredBackendCpu, kLlmActivationDataTypeDefault},
+        {kLlmPreferredBackendCpu, kLlmActivationDataTypeFloat32},
+        {kLlmPreferredBackendCpu, kLlmActivationDataTypeInt8},
+        {kLlmPreferredBackendGpu, kLlmActivationDataTypeDefault},
+        {kLlmPreferredBackendGpu, kLlmActivationDataTypeFloat16},
+        {kLlmPreferredBackendGpu, kLlmActivationDataTypeFloat32},
+    };
+}
+
+} // namespace
+
 std::string MediapipeLlm::generateId() {
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -135,19 +461,39 @@ Value MediapipeLlm::createEngine(Runtime& runtime, const Value& thisValue, const
         throw JSError(runtime, "createEngine requires a settings object");
     }
     
-    auto settings = parseModelSettings(runtime, arguments[0].asObject(runtime));
+    std::vector<size_t> loraRanks;
+    auto settingsObj = arguments[0].asObject(runtime);
+    auto settings = parseModelSettings(runtime, settingsObj, loraRanks);
+    
+    // Only applies a stored result; the search itself is autotune(), which
+    // runs off the JS thread.
+    if (JSI_Helpers::getOptionalBool(runtime, settingsObj, "autotune") && settings.model_path) {
+        Autotuner tuner(JSI_Helpers::getOptionalString(runtime, settingsObj, "cacheDir"));
+        AutotuneResult tuned;
+        if (tuner.lookup(settings.model_path, parseAutotuneConstraints(runtime, settingsObj, settings), tuned)) {
+            LLM_LOGI(AutotuneDone, 0, tuned.candidate.preferredBackend, tuned.candidate.activationDataType, 1);
+            settings.preferred_backend = static_cast<LlmPreferredBackend>(tuned.candidate.preferredBackend);
+            settings.llm_activation_data_type = static_cast<LlmActivationDataType>(tuned.candidate.activationDataType);
+        }
+    }
     
     LlmInferenceEngine_Engine* engine = nullptr;
     char* error_msg = nullptr;
     
+    auto start = std::chrono::steady_clock::now();
     int result = LlmInferenceEngine_CreateEngine(&settings, &engine, &error_msg);
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
     
     if (result != 0 || engine == nullptr) {
+        LLM_LOGE(EngineCreateFailed, elapsedMs);
         std::string errorStr = error_msg ? error_msg : "Unknown error creating engine";
         if (error_msg) free(error_msg);
         throw JSError(runtime, "Failed to create engine: " + errorStr);
     }
     
+    LLM_LOGI(EngineCreate, settings.model_path ? strlen(settings.model_path) : 0, elapsedMs,
+        static_cast<int>(settings.preferred_backend));
+    
     std::string engineId = generateId();
     engines_[engineId] = std::make_unique<EngineWrapper>(engine, engineId);
     
@@ -161,19 +507,160 @@ Value MediapipeLlm::deleteEngine(Runtime& runtime, const Value& thisValue, const
     
     std::string engineId = arguments[0].asString(runtime).utf8(runtime);
     
+    if (engines_.count(engineId)) {
+        destroyEngine(engineId);
+        LLM_LOGI(EngineDelete);
+    }
+    
+    return Value::undefined();
+}
+
+void MediapipeLlm::destroyEngine(const std::string& engineId) {
     auto it = engines_.find(engineId);
-    if (it != engines_.end()) {
-        for (auto sessionIt = sessions_.begin(); sessionIt != sessions_.end();) {
-            if (sessionIt->second->engineId == engineId) {
-                sessionIt = sessions_.erase(sessionIt);
-            } else {
-                ++sessionIt;
+    if (it == engines_.end()) {
+        return;
+    }
+    
+    // Their clones are about to lose their engine; this waits for the workers.
+    retiredDrafts_.erase(engineId);
+    
+    bool stuck = false;
+    for (auto sessionIt = sessions_.begin(); sessionIt != sessions_.end();) {
+        if (sessionIt->second->engineId != engineId) {
+            ++sessionIt;
+            continue;
+        }
+        // Draft and n-best clones belong to the engine too.
+        drafts_.erase(sessionIt->first);
+        std::vector<std::string> groupIds;
+        for (const auto& group : nbestGroups_) {
+            if (group.second->sessionId == sessionIt->first) {
+                groupIds.push_back(group.first);
             }
         }
-        engines_.erase(it);
+        for (const auto& groupId : groupIds) {
+            stuck = !stopNBestGroup(groupId) || stuck;
+        }
+        if (!stopSessionRequests(sessionIt->first)) {
+            // The engine is still calling back into this session; leak it,
+            // and the engine under it, rather than free them mid-decode.
+            sessionIt->second->session = nullptr;
+            stuck = true;
+        }
+        sessionIt = sessions_.erase(sessionIt);
     }
     
-    return Value::undefined();
+    if (stuck) {
+        it->second->engine = nullptr;
+    }
+    engines_.erase(it);
+}
+
+bool MediapipeLlm::stopNBestGroup(const std::string& groupId) {
+    auto groupIt = nbestGroups_.find(groupId);
+    if (groupIt == nbestGroups_.end()) {
+        return true;
+    }
+    auto group = groupIt->second;
+    nbestGroups_.erase(groupIt);
+    
+    for (size_t i = 0; i < group->sessions.size(); ++i) {
+        if (group->streams[i]->isFinished()) {
+            continue;
+        }
+        group->streams[i]->cancel();
+        char* error_msg = nullptr;
+        LlmInferenceEngine_Session_PendingProcessCancellation(group->sessions[i], &error_msg);
+        if (error_msg) free(error_msg);
+    }
+    for (const auto& streamId : group->streamIds) {
+        streams_.erase(streamId);
+        streamSessions_.erase(streamId);
+        streamGroups_.erase(streamId);
+    }
+    
+    auto deadline = std::chrono::steady_clock::now() + kStopRequestTimeout;
+    for (const auto& stream : group->streams) {
+        if (!stream->waitFinished(deadline)) {
+            group->leakSessions = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+void MediapipeLlm::reapNBestGroups() {
+    for (auto it = nbestGroups_.begin(); it != nbestGroups_.end();) {
+        it = it->second->allFinished() ? nbestGroups_.erase(it) : std::next(it);
+    }
+}
+
+void MediapipeLlm::dropDraft(const std::string& sessionId) {
+    reapDrafts();
+    
+    auto draftIt = drafts_.find(sessionId);
+    if (draftIt == drafts_.end()) {
+        return;
+    }
+    draftIt->second->cancel();
+    retiredDrafts_.emplace(sessions_.at(sessionId)->engineId, std::move(draftIt->second));
+    drafts_.erase(draftIt);
+}
+
+void MediapipeLlm::reapDrafts() {
+    for (auto it = retiredDrafts_.begin(); it != retiredDrafts_.end();) {
+        it = it->second->isStopped() ? retiredDrafts_.erase(it) : std::next(it);
+    }
+}
+
+bool MediapipeLlm::hasActiveRequest(const std::string& sessionId) const {
+    for (const auto& entry : streamSessions_) {
+        if (entry.second == sessionId && !streams_.at(entry.first)->isFinished()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MediapipeLlm::stopSessionRequests(const std::string& sessionId) {
+    auto sessionIt = sessions_.find(sessionId);
+    if (sessionIt == sessions_.end()) {
+        return true;
+    }
+    
+    // Same order as cancelPendingProcess: unblock producers parked on
+    // backpressure first, then ask the engine to stop.
+    std::vector<std::shared_ptr<TokenStream>> stopping;
+    for (auto it = streamSessions_.begin(); it != streamSessions_.end();) {
+        if (it->second != sessionId) {
+            ++it;
+            continue;
+        }
+        auto stream = streams_[it->first];
+        if (!stream->isFinished()) {
+            stream->cancel();
+            stopping.push_back(stream);
+        }
+        streams_.erase(it->first);
+        streamGroups_.erase(it->first);
+        it = streamSessions_.erase(it);
+    }
+    
+    if (stopping.empty()) {
+        return true;
+    }
+    
+    char* error_msg = nullptr;
+    LlmInferenceEngine_Session_PendingProcessCancellation(sessionIt->second->session, &error_msg);
+    if (error_msg) free(error_msg);
+    
+    auto deadline = std::chrono::steady_clock::now() + kStopRequestTimeout;
+    for (const auto& stream : stopping) {
+        if (!stream->waitFinished(deadline)) {
+            return false;
+        }
+    }
+    return true;
 }
 
 Value MediapipeLlm::createSession(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
@@ -187,25 +674,217 @@ Value MediapipeLlm::createSession(Runtime& runtime, const Value& thisValue, cons
         throw JSError(runtime, "Engine not found");
     }
     
-    auto config = parseSessionConfig(runtime, arguments[1].asObject(runtime));
+    std::shared_ptr<LoraAdapter> loraAdapter;
+    auto config = parseSessionConfig(runtime, arguments[1].asObject(runtime), loraAdapter);
     
     LlmInferenceEngine_Session* session = nullptr;
     char* error_msg = nullptr;
     
+    auto start = std::chrono::steady_clock::now();
     int result = LlmInferenceEngine_CreateSession(engineIt->second->engine, &config, &session, &error_msg);
     
     if (result != 0 || session == nullptr) {
+        LLM_LOGE(SessionCreateFailed);
         std::string errorStr = error_msg ? error_msg : "Unknown error creating session";
         if (error_msg) free(error_msg);
         throw JSError(runtime, "Failed to create session: " + errorStr);
     }
     
+    LLM_LOGI(SessionCreate, std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count(), loraAdapter ? 1 : 0);
+    
     std::string sessionId = generateId();
-    sessions_[sessionId] = std::make_unique<SessionWrapper>(session, sessionId, engineId);
+    sessions_[sessionId] = std::make_unique<SessionWrapper>(session, sessionId, engineId, config, loraAdapter);
     
     return String::createFromUtf8(runtime, sessionId);
 }
 
+Value MediapipeLlm::swapLoraAdapter(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count < 2 || !arguments[0].isString() || !(arguments[1].isString() || arguments[1].isNull())) {
+        throw JSError(runtime, "swapLoraAdapter requires a session ID and a LoRA path (or null)");
+    }
+    
+    std::string sessionId = arguments[0].asString(runtime).utf8(runtime);
+    auto sessionIt = sessions_.find(sessionId);
+    if (sessionIt == sessions_.end()) {
+        throw JSError(runtime, "Session not found");
+    }
+    
+    auto engineIt = engines_.find(sessionIt->second->engineId);
+    if (engineIt == engines_.end()) {
+        throw JSError(runtime, "Engine not found");
+    }
+    
+    // The old session is deleted below; the engine must not be decoding on it.
+    if (hasActiveRequest(sessionId)) {
+        throw JSError(runtime, "Cannot swap LoRA adapter while a prediction is running; cancel it first");
+    }
+    
+    std::shared_ptr<LoraAdapter> loraAdapter;
+    if (arguments[1].isString()) {
+        std::string error;
+        loraAdapter = loraAdapters_.acquire(arguments[1].asString(runtime).utf8(runtime), error);
+        if (!loraAdapter) {
+            throw JSError(runtime, "Failed to load LoRA adapter: " + error);
+        }
+    }
+    
+    // The base weights stay resident in the engine; only the session is
+    // rebuilt around the new adapter, which the engine reads from disk. The
+    // new session starts empty: the old session's conversation and KV cache
+    // are dropped, so callers must replay any history they want to keep.
+    LlmSessionConfig config = sessionIt->second->config;
+    config.lora_path = loraAdapter ? loraAdapter->path.c_str() : nullptr;
+    
+    LlmInferenceEngine_Session* session = nullptr;
+    char* error_msg = nullptr;
+    
+    auto start = std::chrono::steady_clock::now();
+    int result = LlmInferenceEngine_CreateSession(engineIt->second->engine, &config, &session, &error_msg);
+    
+    if (result != 0 || session == nullptr) {
+        LLM_LOGE(SessionCreateFailed);
+        std::string errorStr = error_msg ? error_msg : "Unknown error creating session";
+        if (error_msg) free(error_msg);
+        throw JSError(runtime, "Failed to swap LoRA adapter: " + errorStr);
+    }
+    
+    LLM_LOGI(LoraSwap, loraAdapter ? loraAdapter->sizeBytes : 0, std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    
+    // A draft prefilled under the old adapter is of no use to the new one.
+    dropDraft(sessionId);
+    sessionIt->second = std::make_unique<SessionWrapper>(session, sessionId, engineIt->first, config, loraAdapter);
+    
+    return Value::undefined();
+}
+
+Value MediapipeLlm::getLoraAdapterStats(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    auto stats = loraAdapters_.stats();
+    
+    auto statsObj = Object(runtime);
+    statsObj.setProperty(runtime, "inUse", Value(static_cast<double>(stats.inUse)));
+    statsObj.setProperty(runtime, "inUseBytes", Value(static_cast<double>(stats.inUseBytes)));
+    
+    return statsObj;
+}
+
+Value MediapipeLlm::addQueryChunk(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count < 2 || !arguments[0].isString() || !arguments[1].isString()) {
+        throw JSError(runtime, "addQueryChunk requires a session ID and a text string");
+    }
+    
+    std::string sessionId = arguments[0].asString(runtime).utf8(runtime);
+    auto sessionIt = sessions_.find(sessionId);
+    if (sessionIt == sessions_.end()) {
+        throw JSError(runtime, "Session not found");
+    }
+    
+    // A draft's root clone predates this text.
+    dropDraft(sessionId);
+    
+    std::string text = arguments[1].asString(runtime).utf8(runtime);
+    char* error_msg = nullptr;
+    
+    int result = LlmInferenceEngine_Session_AddQueryChunk(sessionIt->second->session, text.c_str(), &error_msg);
+    
+    if (result != 0) {
+        std::string errorStr = error_msg ? error_msg : "Unknown error adding query chunk";
+        if (error_msg) free(error_msg);
+        throw JSError(runtime, "Failed to add query chunk: " + errorStr);
+    }
+    
+    return Value::undefined();
+}
+
+Value MediapipeLlm::updateDraft(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count < 2 || !arguments[0].isString() || !arguments[1].isString()) {
+        throw JSError(runtime, "updateDraft requires a session ID and the draft text");
+    }
+    
+    std::string sessionId = arguments[0].asString(runtime).utf8(runtime);
+    auto sessionIt = sessions_.find(sessionId);
+    if (sessionIt == sessions_.end()) {
+        throw JSError(runtime, "Session not found");
+    }
+    
+    // Cloning now would race the engine, and the clone would miss the reply
+    // being decoded. Updates carry the whole draft, so the next keystroke
+    // after the prediction ends starts over with the complete text.
+    if (hasActiveRequest(sessionId)) {
+        dropDraft(sessionId);
+        return Value::undefined();
+    }
+    
+    auto& draft = drafts_[sessionId];
+    if (!draft) {
+        draft = std::make_unique<DraftPrefill>(sessionIt->second->session, draftSessionOps());
+        if (!draft->valid()) {
+            drafts_.erase(sessionId);
+            throw JSError(runtime, "Failed to start draft prefill: session could not be cloned");
+        }
+    }
+    
+    draft->update(arguments[1].asString(runtime).utf8(runtime));
+    
+    return Value::undefined();
+}
+
+Value MediapipeLlm::commitDraft(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count < 2 || !arguments[0].isString() || !arguments[1].isString()) {
+        throw JSError(runtime, "commitDraft requires a session ID and the final text");
+    }
+    
+    std::string sessionId = arguments[0].asString(runtime).utf8(runtime);
+    auto sessionIt = sessions_.find(sessionId);
+    if (sessionIt == sessions_.end()) {
+        throw JSError(runtime, "Session not found");
+    }
+    
+    std::string text = arguments[1].asString(runtime).utf8(runtime);
+    
+    // The original session is deleted below; the engine must not be decoding on it.
+    if (hasActiveRequest(sessionId)) {
+        throw JSError(runtime, "Cannot commit draft while a prediction is running; cancel it first");
+    }
+    
+    auto draftIt = drafts_.find(sessionId);
+    if (draftIt == drafts_.end()) {
+        // Nothing was typed through updateDraft; behave like addQueryChunk.
+        addQueryChunk(runtime, thisValue, arguments, count);
+        return createDraftStatsObject(runtime, DraftPrefillStats{});
+    }
+    
+    std::unique_ptr<DraftPrefill> draft = std::move(draftIt->second);
+    drafts_.erase(draftIt);
+    
+    std::string error;
+    void* prefilled = draft->commit(text, error);
+    auto stats = draft->stats();
+    if (!prefilled) {
+        throw JSError(runtime, "Failed to commit draft: " + error);
+    }
+    LLM_LOGI(DraftCommit, stats.prefilledChars, text.size() - stats.prefilledChars, stats.chunks, stats.rewinds);
+    
+    // The prefilled clone carries the session's history plus the query, so
+    // it takes the original's place under the same ID.
+    auto* wrapper = sessionIt->second.get();
+    LlmInferenceEngine_Session_Delete(wrapper->session);
+    wrapper->session = static_cast<LlmInferenceEngine_Session*>(prefilled);
+    
+    return createDraftStatsObject(runtime, stats);
+}
+
+Value MediapipeLlm::discardDraft(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count == 0 || !arguments[0].isString()) {
+        throw JSError(runtime, "discardDraft requires a session ID string");
+    }
+    
+    dropDraft(arguments[0].asString(runtime).utf8(runtime));
+    
+    return Value::undefined();
+}
+
 Value MediapipeLlm::predictSync(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
     if (count == 0 || !arguments[0].isString()) {
         throw JSError(runtime, "predictSync requires a session ID string");
@@ -217,23 +896,671 @@ Value MediapipeLlm::predictSync(Runtime& runtime, const Value& thisValue, const
         throw JSError(runtime, "Session not found");
     }
     
+    // The reply becomes part of the session's context; a draft cloned
+    // before it would commit without it.
+    dropDraft(sessionId);
+    
     LlmResponseContext response = {};
     char* error_msg = nullptr;
     
+    auto start = std::chrono::steady_clock::now();
     int result = LlmInferenceEngine_Session_PredictSync(sessionIt->second->session, &response, &error_msg);
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
     
     if (result != 0) {
+        LLM_LOGE(GenerateFailed, elapsedMs);
         std::string errorStr = error_msg ? error_msg : "Unknown error during prediction";
         if (error_msg) free(error_msg);
         throw JSError(runtime, "Prediction failed: " + errorStr);
     }
     
+    LLM_LOGI(GenerateDone, response.response_count > 0 && response.response_array[0] ? strlen(response.response_array[0]) : 0, elapsedMs);
+    
     auto responseObj = createResponseObject(runtime, response);
     LlmInferenceEngine_CloseResponseContext(&response);
     
     return responseObj;
 }
 
+Value MediapipeLlm::inspectModel(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count == 0 || !arguments[0].isString()) {
+        throw JSError(runtime, "inspectModel requires a model path string");
+    }
+    
+    auto caps = TaskBundleInspector::inspect(arguments[0].asString(runtime).utf8(runtime));
+    if (!caps->ok) {
+        throw JSError(runtime, "Failed to inspect model: " + caps->error);
+    }
+    
+    auto capsObj = Object(runtime);
+    capsObj.setProperty(runtime, "contextLength", Value(static_cast<double>(caps->contextLength)));
+    capsObj.setProperty(runtime, "vocabSize", Value(static_cast<double>(caps->vocabSize)));
+    capsObj.setProperty(runtime, "supportsVision", Value(caps->supportsVision));
+    capsObj.setProperty(runtime, "supportsAudio", Value(caps->supportsAudio));
+    capsObj.setProperty(runtime, "weightType", String::createFromUtf8(runtime, caps->weightType));
+    capsObj.setProperty(runtime, "fileSizeBytes", Value(static_cast<double>(caps->fileSizeBytes)));
+    capsObj.setProperty(runtime, "weightBytes", Value(static_cast<double>(caps->weightBytes)));
+    capsObj.setProperty(runtime, "kvCacheBytes", Value(static_cast<double>(caps->kvCacheBytes)));
+    capsObj.setProperty(runtime, "estimatedMemoryBytes", Value(static_cast<double>(caps->estimatedMemoryBytes)));
+    
+    auto entries = Array(runtime, caps->entries.size());
+    for (size_t i = 0; i < caps->entries.size(); ++i) {
+        auto entryObj = Object(runtime);
+        entryObj.setProperty(runtime, "name", String::createFromUtf8(runtime, caps->entries[i].name));
+        entryObj.setProperty(runtime, "sizeBytes", Value(static_cast<double>(caps->entries[i].uncompressedSize)));
+        entries.setValueAtIndex(runtime, i, entryObj);
+    }
+    capsObj.setProperty(runtime, "entries", entries);
+    
+    return capsObj;
+}
+
+Value MediapipeLlm::autotune(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count < 2 || !arguments[0].isObject() || !arguments[1].isObject() ||
+        !arguments[1].asObject(runtime).isFunction(runtime)) {
+        throw JSError(runtime, "autotune requires a settings object and a completion callback");
+    }
+    if (!jsScheduler_) {
+        throw JSError(runtime, "autotune needs a JS scheduler to report its result");
+    }
+    
+    std::vector<size_t> loraRanks;
+    auto settingsObj = arguments[0].asObject(runtime);
+    auto settings = parseModelSettings(runtime, settingsObj, loraRanks);
+    if (!settings.model_path) {
+        throw JSError(runtime, "Autotune requires modelPath");
+    }
+    
+    std::string cacheDir = JSI_Helpers::getOptionalString(runtime, settingsObj, "cacheDir");
+    bool retune = JSI_Helpers::getOptionalBool(runtime, settingsObj, "autotuneForce");
+    AutotuneConstraints constraints = parseAutotuneConstraints(runtime, settingsObj, settings);
+    
+    if (autotuneRunning.exchange(true)) {
+        throw JSError(runtime, "An autotune search is already running");
+    }
+    
+    auto scheduler = jsScheduler_;
+    auto onDone = std::shared_ptr<Function>(
+        new Function(arguments[1].asObject(runtime).asFunction(runtime)),
+        [scheduler](Function* fn) { scheduler([fn] { delete fn; }); });
+    Runtime* rt = &runtime;
+    
+    // Loads one engine per candidate, so it never runs on the JS thread. The
+    // worker owns copies of everything it needs and never touches `this`.
+    std::thread([scheduler, onDone, rt, settings, loraRanks, cacheDir, retune, constraints]() mutable {
+        settings.supported_lora_ranks = loraRanks.empty() ? nullptr : loraRanks.data();
+        
+        Autotuner tuner(cacheDir);
+        AutotuneResult result;
+        if (retune || !tuner.lookup(settings.model_path, constraints, result)) {
+            auto candidates = defaultAutotuneCandidates();
+            result = tuner.tune(settings.model_path, constraints, candidates,
+                [&settings](const AutotuneCandidate& candidate) {
+                    return benchmarkCandidate(settings, candidate);
+                });
+            LLM_LOGI(AutotuneDone, candidates.size(), result.candidate.preferredBackend, result.candidate.activationDataType, 0);
+        } else {
+            LLM_LOGI(AutotuneDone, 0, result.candidate.preferredBackend, result.candidate.activationDataType, 1);
+        }
+        autotuneRunning.store(false);
+        
+        scheduler([onDone, rt, result] {
+            if (result.ok) {
+                onDone->call(*rt, createAutotuneObject(*rt, result));
+            } else {
+                onDone->call(*rt, Value::null(),
+                    String::createFromUtf8(*rt, "Autotune failed: no candidate configuration could be benchmarked"));
+            }
+        });
+    }).detach();
+    
+    return Value::undefined();
+}
+
+AutotuneConstraints MediapipeLlm::parseAutotuneConstraints(Runtime& runtime, const Object& settingsObj, const LlmModelSettings& settings) {
+    AutotuneConstraints constraints;
+    constraints.memoryCeilingBytes = static_cast<size_t>(
+        JSI_Helpers::getOptionalNumber(runtime, settingsObj, "autotuneMemoryCeilingMB") * 1024 * 1024);
+    constraints.maxNumTokens = settings.max_num_tokens;
+    return constraints;
+}
+
+AutotuneMeasurement MediapipeLlm::benchmarkCandidate(const LlmModelSettings& settings, const AutotuneCandidate& candidate) {
+    AutotuneMeasurement measurement;
+    size_t baselineRss = Autotuner::residentMemoryBytes();
+    size_t peakRss = baselineRss;
+    
+    LlmModelSettings candidateSettings = settings;
+    candidateSettings.preferred_backend = static_cast<LlmPreferredBackend>(candidate.preferredBackend);
+    candidateSettings.llm_activation_data_type = static_cast<LlmActivationDataType>(candidate.activationDataType);
+    
+    LlmInferenceEngine_Engine* engine = nullptr;
+    char* error_msg = nullptr;
+    
+    if (LlmInferenceEngine_CreateEngine(&candidateSettings, &engine, &error_msg) != 0 || engine == nullptr) {
+        measurement.error = error_msg ? error_msg : "Unknown error creating engine";
+        if (error_msg) free(error_msg);
+        return measurement;
+    }
+    peakRss = std::max(peakRss, Autotuner::residentMemoryBytes());
+    
+    LlmSessionConfig config = {};
+    config.topk = 1;
+    config.temperature = 0.0f;
+    
+    LlmInferenceEngine_Session* session = nullptr;
+    if (LlmInferenceEngine_CreateSession(engine, &config, &session, &error_msg) != 0 || session == nullptr) {
+        measurement.error = error_msg ? error_msg : "Unknown error creating session";
+        if (error_msg) free(error_msg);
+        LlmInferenceEngine_Engine_Delete(engine);
+        return measurement;
+    }
+    
+    auto sizeInTokens = [session](const std::string& text) {
+        char* error = nullptr;
+        int tokens = LlmInferenceEngine_Session_SizeInTokens(session, text.c_str(), &error);
+        if (error) free(error);
+        return tokens;
+    };
+    
+    std::string prompt;
+    int promptTokens = 0;
+    while (promptTokens >= 0 && static_cast<size_t>(promptTokens) < Autotuner::kReferencePromptTokens) {
+        prompt += kBenchmarkSentence;
+        promptTokens = sizeInTokens(prompt);
+    }
+    
+    auto state = std::make_shared<BenchmarkState>();
+    auto* holder = new std::shared_ptr<BenchmarkState>(state);
+    auto start = std::chrono::steady_clock::now();
+    
+    int result = LlmInferenceEngine_Session_AddQueryChunk(session, prompt.c_str(), &error_msg);
+    if (result == 0) {
+        result = LlmInferenceEngine_Session_PredictAsync(session, holder, &error_msg, onBenchmarkResponse);
+    }
+    
+    bool stopped = true;
+    if (result != 0) {
+        delete holder;
+        measurement.error = error_msg ? error_msg : "Unknown error during prediction";
+        if (error_msg) free(error_msg);
+    } else {
+        // Callbacks are a cheap lower bound on tokens; the measurement itself
+        // tokenizes what was produced, since one callback may carry several.
+        std::unique_lock<std::mutex> lock(state->mutex);
+        auto measured = [&state] { return state->done || state->chunks > kBenchmarkDecodeTokens; };
+        while (!state->cv.wait_for(lock, kBenchmarkMemorySampleInterval, measured)) {
+            lock.unlock();
+            peakRss = std::max(peakRss, Autotuner::residentMemoryBytes());
+            lock.lock();
+        }
+        size_t decodedChunks = state->chunks;
+        auto firstChunk = state->firstChunk;
+        auto lastChunk = state->lastChunk;
+        std::string firstText = state->firstText;
+        std::string decodedText = state->text;
+        std::string error = state->error;
+        
+        if (!state->done) {
+            lock.unlock();
+            LlmInferenceEngine_Session_PendingProcessCancellation(session, &error_msg);
+            if (error_msg) free(error_msg);
+            lock.lock();
+            stopped = state->cv.wait_for(lock, kBenchmarkCancelTimeout, [&state] { return state->done; });
+        }
+        lock.unlock();
+        
+        if (!stopped) {
+            measurement.error = "Benchmark decode did not stop after cancellation";
+        } else if (!error.empty() && decodedChunks == 0) {
+            measurement.error = error;
+        } else if (decodedChunks > 1) {
+            int decodedTokens = sizeInTokens(decodedText) - sizeInTokens(firstText);
+            std::chrono::duration<double> prefillSeconds = firstChunk - start;
+            std::chrono::duration<double> decodeSeconds = lastChunk - firstChunk;
+            if (decodedTokens > 0 && decodeSeconds.count() > 0) {
+                measurement.prefillTokensPerSec = promptTokens / prefillSeconds.count();
+                measurement.decodeTokensPerSec = decodedTokens / decodeSeconds.count();
+                measurement.ok = true;
+            } else {
+                measurement.error = "Benchmark produced too few tokens to measure decode";
+            }
+        } else {
+            measurement.error = "Benchmark produced too few tokens to measure decode";
+        }
+    }
+    
+    peakRss = std::max(peakRss, Autotuner::residentMemoryBytes());
+    measurement.peakMemoryBytes = peakRss - baselineRss;
+    
+    // A decode that ignored the cancel still owns the session; leaking the
+    // candidate beats deleting it under the engine.
+    if (stopped) {
+        LlmInferenceEngine_Session_Delete(session);
+        LlmInferenceEngine_Engine_Delete(engine);
+    }
+    
+    return measurement;
+}
+
+Object MediapipeLlm::createAutotuneObject(Runtime& runtime, const AutotuneResult& result) {
+    auto resultObj = Object(runtime);
+    
+    resultObj.setProperty(runtime, "preferredBackend", Value(result.candidate.preferredBackend));
+    resultObj.setProperty(runtime, "activationDataType", Value(result.candidate.activationDataType));
+    resultObj.setProperty(runtime, "prefillTokensPerSec", Value(result.measurement.prefillTokensPerSec));
+    resultObj.setProperty(runtime, "decodeTokensPerSec", Value(result.measurement.decodeTokensPerSec));
+    resultObj.setProperty(runtime, "peakMemoryBytes", Value(static_cast<double>(result.measurement.peakMemoryBytes)));
+    resultObj.setProperty(runtime, "fromCache", Value(result.fromCache));
+    
+    return resultObj;
+}
+
+Value MediapipeLlm::setThreadPolicy(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count == 0 || !arguments[0].isObject()) {
+        throw JSError(runtime, "setThreadPolicy requires a policy object");
+    }
+    
+    auto policyObj = arguments[0].asObject(runtime);
+    ThreadPolicy policy = ThreadPlacement::shared().policy();
+    
+    policy.pinDecodeToPerformanceCores = JSI_Helpers::getOptionalBool(
+        runtime, policyObj, "pinDecodeToPerformanceCores", policy.pinDecodeToPerformanceCores);
+    policy.pinBackgroundToEfficiencyCores = JSI_Helpers::getOptionalBool(
+        runtime, policyObj, "pinBackgroundToEfficiencyCores", policy.pinBackgroundToEfficiencyCores);
+    policy.decodeNice = static_cast<int>(JSI_Helpers::getOptionalNumber(runtime, policyObj, "decodeNice", policy.decodeNice));
+    policy.backgroundNice = static_cast<int>(JSI_Helpers::getOptionalNumber(runtime, policyObj, "backgroundNice", policy.backgroundNice));
+    
+    ThreadPlacement::shared().setPolicy(policy);
+    
+    return Value::undefined();
+}
+
+Value MediapipeLlm::getThreadStats(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    auto& placement = ThreadPlacement::shared();
+    const auto& topology = placement.topology();
+    
+    auto statsObj = Object(runtime);
+    
+    auto performanceCores = Array(runtime, topology.performanceCores.size());
+    for (size_t i = 0; i < topology.performanceCores.size(); ++i) {
+        performanceCores.setValueAtIndex(runtime, i, Value(topology.performanceCores[i]));
+    }
+    auto efficiencyCores = Array(runtime, topology.efficiencyCores.size());
+    for (size_t i = 0; i < topology.efficiencyCores.size(); ++i) {
+        efficiencyCores.setValueAtIndex(runtime, i, Value(topology.efficiencyCores[i]));
+    }
+    statsObj.setProperty(runtime, "performanceCores", performanceCores);
+    statsObj.setProperty(runtime, "efficiencyCores", efficiencyCores);
+    
+    auto roles = Object(runtime);
+    for (const auto& role : placement.stats()) {
+        auto roleObj = Object(runtime);
+        roleObj.setProperty(runtime, "threads", Value(static_cast<double>(role.threads)));
+        roleObj.setProperty(runtime, "cpuSeconds", Value(role.cpuSeconds));
+        roles.setProperty(runtime, threadRoleName(role.role), roleObj);
+    }
+    statsObj.setProperty(runtime, "roles", roles);
+    
+    return statsObj;
+}
+
+Value MediapipeLlm::predictAsync(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count == 0 || !arguments[0].isString()) {
+        throw JSError(runtime, "predictAsync requires a session ID string");
+    }
+    
+    std::string sessionId = arguments[0].asString(runtime).utf8(runtime);
+    auto sessionIt = sessions_.find(sessionId);
+    if (sessionIt == sessions_.end()) {
+        throw JSError(runtime, "Session not found");
+    }
+    
+    // Two decodes on one session would interleave their tokens.
+    if (hasActiveRequest(sessionId)) {
+        throw JSError(runtime, "Cannot start a prediction while another is running on this session");
+    }
+    
+    TokenStreamOptions options;
+    ThreadRole role = ThreadRole::Decode;
+    if (count > 2 && arguments[2].isObject()) {
+        auto optionsObj = arguments[2].asObject(runtime);
+        role = requestRole(runtime, optionsObj);
+        options = streamOptions(runtime, optionsObj);
+    }
+    
+    // Same as predictSync; updateDraft then waits for the decode to end.
+    dropDraft(sessionId);
+    
+    std::string requestId = generateId();
+    
+    TokenStream::NotifyFn notify;
+    if (count > 1 && arguments[1].isObject() && arguments[1].asObject(runtime).isFunction(runtime) && jsScheduler_) {
+        auto scheduler = jsScheduler_;
+        // The stream can outlive its last JS reference on the decode thread,
+        // so the JS function is always released back on the JS thread.
+        auto onData = std::shared_ptr<Function>(
+            new Function(arguments[1].asObject(runtime).asFunction(runtime)),
+            [scheduler](Function* fn) { scheduler([fn] { delete fn; }); });
+        Runtime* rt = &runtime;
+        notify = [scheduler, onData, rt, requestId] {
+            scheduler([onData, rt, requestId] {
+                onData->call(*rt, String::createFromUtf8(*rt, requestId));
+            });
+        };
+    }
+    
+    auto stream = std::make_shared<TokenStream>(options, std::move(notify));
+    auto* request = new AsyncRequest{stream, nullptr, 0, role};
+    char* error_msg = nullptr;
+    
+    int result = LlmInferenceEngine_Session_PredictAsync(sessionIt->second->session, request, &error_msg, onAsyncResponse);
+    
+    if (result != 0) {
+        delete request;
+        std::string errorStr = error_msg ? error_msg : "Unknown error during prediction";
+        if (error_msg) free(error_msg);
+        throw JSError(runtime, "Prediction failed: " + errorStr);
+    }
+    
+    LLM_LOGD(PredictAsync);
+    
+    streams_[requestId] = stream;
+    streamSessions_[requestId] = sessionId;
+    
+    return String::createFromUtf8(runtime, requestId);
+}
+
+Value MediapipeLlm::predictNBest(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count < 2 || !arguments[0].isString() || !arguments[1].isObject()) {
+        throw JSError(runtime, "predictNBest requires a session ID and an options object");
+    }
+    
+    std::string sessionId = arguments[0].asString(runtime).utf8(runtime);
+    auto sessionIt = sessions_.find(sessionId);
+    if (sessionIt == sessions_.end()) {
+        throw JSError(runtime, "Session not found");
+    }
+    
+    // The candidates are cloned from the session, which must not be mid-decode.
+    if (hasActiveRequest(sessionId)) {
+        throw JSError(runtime, "Cannot start n-best while a prediction is running; cancel it first");
+    }
+    
+    auto optionsObj = arguments[1].asObject(runtime);
+    std::string prompt = JSI_Helpers::getOptionalString(runtime, optionsObj, "prompt");
+    // Range-checked as doubles: casting a negative or NaN value is undefined.
+    double requested = JSI_Helpers::getOptionalNumber(runtime, optionsObj, "n", 0);
+    if (prompt.empty() || !(requested >= 1) || requested > kMaxNBestCandidates) {
+        throw JSError(runtime, "predictNBest requires a prompt and 1-" + std::to_string(kMaxNBestCandidates) + " candidates");
+    }
+    size_t n = static_cast<size_t>(requested);
+    double earlyStopAfter = JSI_Helpers::getOptionalNumber(runtime, optionsObj, "earlyStopAfter", static_cast<double>(n));
+    if (!(earlyStopAfter >= 1)) {
+        throw JSError(runtime, "earlyStopAfter must be at least 1");
+    }
+    
+    reapNBestGroups();
+    
+    auto group = std::make_shared<NBestGroup>();
+    group->sessionId = sessionId;
+    group->stopAfter = static_cast<size_t>(std::min(earlyStopAfter, static_cast<double>(n)));
+    
+    ThreadRole role = requestRole(runtime, optionsObj);
+    
+    TokenStreamOptions candidateOptions = streamOptions(runtime, optionsObj);
+    
+    // Prefill once on a private clone so the caller's session is untouched,
+    // then fork the prefilled state into the remaining candidates.
+    LlmInferenceEngine_Session* prefilled = nullptr;
+    char* error_msg = nullptr;
+    
+    int result = LlmInferenceEngine_Session_Clone(sessionIt->second->session, &prefilled, &error_msg);
+    if (result == 0 && prefilled) {
+        group->sessions.push_back(prefilled);
+        result = LlmInferenceEngine_Session_AddQueryChunk(prefilled, prompt.c_str(), &error_msg);
+    }
+    for (size_t i = 1; result == 0 && i < n; ++i) {
+        LlmInferenceEngine_Session* clone = nullptr;
+        result = LlmInferenceEngine_Session_Clone(prefilled, &clone, &error_msg);
+        if (result == 0 && clone) {
+            group->sessions.push_back(clone);
+        }
+    }
+    
+    if (result != 0 || group->sessions.size() != n) {
+        std::string errorStr = error_msg ? error_msg : "Unknown error preparing candidates";
+        if (error_msg) free(error_msg);
+        throw JSError(runtime, "Failed to prepare n-best candidates: " + errorStr);
+    }
+    
+    LLM_LOGI(NBestStart, n, group->stopAfter, prompt.size());
+    
+    // Every candidate samples differently: seeds are spread from the
+    // session's own, and options.candidates[i] may override any parameter.
+    const auto& baseConfig = sessionIt->second->config;
+    auto overrides = JSI_Helpers::getOptionalArray(runtime, optionsObj, "candidates");
+    for (size_t i = 0; i < n; ++i) {
+        SessionRuntimeConfig runtimeConfig = {};
+        runtimeConfig.topk = baseConfig.topk;
+        runtimeConfig.topp = baseConfig.topp;
+        runtimeConfig.temperature = baseConfig.temperature;
+        runtimeConfig.random_seed = baseConfig.random_seed + i;
+        
+        if (i < overrides.size(runtime) && overrides.getValueAtIndex(runtime, i).isObject()) {
+            auto candidateObj = overrides.getValueAtIndex(runtime, i).asObject(runtime);
+            runtimeConfig.topk = static_cast<size_t>(JSI_Helpers::getOptionalNumber(
+                runtime, candidateObj, "topK", static_cast<double>(runtimeConfig.topk)));
+            runtimeConfig.topp = static_cast<float>(JSI_Helpers::getOptionalNumber(
+                runtime, candidateObj, "topP", runtimeConfig.topp));
+            runtimeConfig.temperature = static_cast<float>(JSI_Helpers::getOptionalNumber(
+                runtime, candidateObj, "temperature", runtimeConfig.temperature));
+            runtimeConfig.random_seed = static_cast<size_t>(JSI_Helpers::getOptionalNumber(
+                runtime, candidateObj, "randomSeed", static_cast<double>(runtimeConfig.random_seed)));
+        }
+        
+        if (LlmInferenceEngine_Session_UpdateRuntimeConfig(group->sessions[i], &runtimeConfig, &error_msg) != 0) {
+            std::string errorStr = error_msg ? error_msg : "Unknown error updating sampling parameters";
+            if (error_msg) free(error_msg);
+            throw JSError(runtime, "Failed to configure n-best candidate: " + errorStr);
+        }
+    }
+    
+    std::string requestId = generateId();
+    
+    std::shared_ptr<Function> onCandidate;
+    if (count > 2 && arguments[2].isObject() && arguments[2].asObject(runtime).isFunction(runtime) && jsScheduler_) {
+        auto scheduler = jsScheduler_;
+        onCandidate = std::shared_ptr<Function>(
+            new Function(arguments[2].asObject(runtime).asFunction(runtime)),
+            [scheduler](Function* fn) { scheduler([fn] { delete fn; }); });
+    }
+    
+    for (size_t i = 0; i < n; ++i) {
+        std::string streamId = requestId + ":" + std::to_string(i);
+        
+        TokenStream::NotifyFn notify;
+        if (onCandidate) {
+            auto scheduler = jsScheduler_;
+            Runtime* rt = &runtime;
+            notify = [scheduler, onCandidate, rt, streamId, i] {
+                scheduler([onCandidate, rt, streamId, i] {
+                    onCandidate->call(*rt, Value(static_cast<double>(i)), String::createFromUtf8(*rt, streamId));
+                });
+            };
+        }
+        
+        group->streams.push_back(std::make_shared<TokenStream>(candidateOptions, std::move(notify)));
+        group->streamIds.push_back(streamId);
+    }
+    
+    // Register before starting so a fast candidate can't finish unseen.
+    nbestGroups_[requestId] = group;
+    for (size_t i = 0; i < n; ++i) {
+        streams_[group->streamIds[i]] = group->streams[i];
+        streamSessions_[group->streamIds[i]] = sessionId;
+        streamGroups_[group->streamIds[i]] = NBestStreamRef{requestId, i};
+    }
+    
+    for (size_t i = 0; i < n; ++i) {
+        auto* request = new AsyncRequest{group->streams[i], group, i, role};
+        if (LlmInferenceEngine_Session_PredictAsync(group->sessions[i], request, &error_msg, onAsyncResponse) != 0) {
+            std::string errorStr = error_msg ? error_msg : "Unknown error during prediction";
+            if (error_msg) free(error_msg);
+            error_msg = nullptr;
+            onCandidateDone(group.get(), i);
+            group->streams[i]->finish(errorStr);
+            delete request;
+        }
+    }
+    
+    auto streamIds = Array(runtime, n);
+    for (size_t i = 0; i < n; ++i) {
+        streamIds.setValueAtIndex(runtime, i, String::createFromUtf8(runtime, group->streamIds[i]));
+    }
+    
+    auto requestObj = Object(runtime);
+    requestObj.setProperty(runtime, "requestId", String::createFromUtf8(runtime, requestId));
+    requestObj.setProperty(runtime, "streams", streamIds);
+    
+    return requestObj;
+}
+
+Value MediapipeLlm::readStream(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count == 0 || !arguments[0].isString()) {
+        throw JSError(runtime, "readStream requires a request ID string");
+    }
+    
+    std::string requestId = arguments[0].asString(runtime).utf8(runtime);
+    auto streamIt = streams_.find(requestId);
+    if (streamIt == streams_.end()) {
+        throw JSError(runtime, "Stream not found");
+    }
+    
+    auto stream = streamIt->second;
+    bool finished = false;
+    auto data = stream->take(finished);
+    
+    auto chunkObj = Object(runtime);
+    chunkObj.setProperty(runtime, "data", ArrayBuffer(runtime, std::make_shared<StringBuffer>(std::move(data))));
+    chunkObj.setProperty(runtime, "done", Value(finished));
+    
+    if (finished) {
+        auto error = stream->error();
+        if (!error.empty()) {
+            chunkObj.setProperty(runtime, "error", String::createFromUtf8(runtime, error));
+        }
+        streams_.erase(streamIt);
+        streamSessions_.erase(requestId);
+        streamGroups_.erase(requestId);
+    }
+    
+    // Candidate sessions are freed as soon as every candidate has stopped,
+    // whether or not JS has drained the other streams yet.
+    reapNBestGroups();
+    
+    return chunkObj;
+}
+
+Value MediapipeLlm::releaseNBest(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count == 0 || !arguments[0].isString()) {
+        throw JSError(runtime, "releaseNBest requires an n-best request ID string");
+    }
+    
+    // Also drops streams JS never read; needed when the caller abandons a
+    // request instead of draining every candidate.
+    stopNBestGroup(arguments[0].asString(runtime).utf8(runtime));
+    
+    return Value::undefined();
+}
+
+Value MediapipeLlm::cancelPendingProcess(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count == 0 || !arguments[0].isString()) {
+        throw JSError(runtime, "cancelPendingProcess requires a session ID string");
+    }
+    
+    std::string sessionId = arguments[0].asString(runtime).utf8(runtime);
+    auto sessionIt = sessions_.find(sessionId);
+    if (sessionIt == sessions_.end()) {
+        throw JSError(runtime, "Session not found");
+    }
+    
+    // Unblock producers stuck on backpressure before asking the engine to
+    // stop, otherwise cancellation could wait on a callback that never returns.
+    for (const auto& entry : streamSessions_) {
+        if (entry.second == sessionId) {
+            streams_[entry.first]->cancel();
+            
+            // N-best candidates decode on clones, not on the session itself.
+            auto groupIt = streamGroups_.find(entry.first);
+            auto nbestIt = groupIt != streamGroups_.end() ? nbestGroups_.find(groupIt->second.groupId) : nbestGroups_.end();
+            if (nbestIt != nbestGroups_.end()) {
+                char* error_msg = nullptr;
+                LlmInferenceEngine_Session_PendingProcessCancellation(
+                    nbestIt->second->sessions[groupIt->second.index], &error_msg);
+                if (error_msg) free(error_msg);
+            }
+        }
+    }
+    
+    char* error_msg = nullptr;
+    int result = LlmInferenceEngine_Session_PendingProcessCancellation(sessionIt->second->session, &error_msg);
+    
+    if (result != 0) {
+        std::string errorStr = error_msg ? error_msg : "Unknown error cancelling prediction";
+        if (error_msg) free(error_msg);
+        throw JSError(runtime, "Cancellation failed: " + errorStr);
+    }
+    
+    return Value::undefined();
+}
+
+Value MediapipeLlm::dumpLogs(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    size_t maxRecords = Logger::kHistoryCapacity;
+    if (count > 0 && arguments[0].isNumber() && arguments[0].asNumber() > 0) {
+        maxRecords = static_cast<size_t>(arguments[0].asNumber());
+    }
+    
+    return String::createFromUtf8(runtime, Logger::shared().dump(maxRecords));
+}
+
+Value MediapipeLlm::setLogSink(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    if (count == 0 || !arguments[0].isString()) {
+        throw JSError(runtime, "setLogSink requires 'platform', 'file' or 'none'");
+    }
+    
+    std::string name = arguments[0].asString(runtime).utf8(runtime);
+    std::string path = count > 1 && arguments[1].isString() ? arguments[1].asString(runtime).utf8(runtime) : "";
+    
+    LogSink sink;
+    if (name == "platform") {
+        sink = LogSink::Platform;
+    } else if (name == "none") {
+        sink = LogSink::None;
+    } else if (name == "file" && !path.empty()) {
+        sink = LogSink::File;
+    } else {
+        throw JSError(runtime, "setLogSink requires 'platform', 'file' (with a path) or 'none'");
+    }
+    
+    if (!Logger::shared().setSink(sink, path)) {
+        throw JSError(runtime, "Failed to open log file: " + path);
+    }
+    
+    return Value::undefined();
+}
+
+Value MediapipeLlm::getLogStats(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
+    auto stats = Logger::shared().stats();
+    
+    auto statsObj = Object(runtime);
+    statsObj.setProperty(runtime, "recorded", Value(static_cast<double>(stats.recorded)));
+    statsObj.setProperty(runtime, "dropped", Value(static_cast<double>(stats.dropped)));
+    statsObj.setProperty(runtime, "threads", Value(static_cast<double>(stats.threads)));
+    
+    return statsObj;
+}
+
 Value MediapipeLlm::multiply(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count) {
     if (count < 2 || !arguments[0].isNumber() || !arguments[1].isNumber()) {
         throw JSError(runtime, "multiply requires two numbers");
@@ -245,7 +1572,7 @@ Value MediapipeLlm::multiply(Runtime& runtime, const Value& thisValue, const Val
     return Value(a * b);
 }
 
-LlmModelSettings MediapipeLlm::parseModelSettings(Runtime& runtime, const Object& settings) {
+LlmModelSettings MediapipeLlm::parseModelSettings(Runtime& runtime, const Object& settings, std::vector<size_t>& loraRanks) {
     LlmModelSettings modelSettings = {};
     
     if (settings.hasProperty(runtime, "modelPath")) {
@@ -253,6 +1580,13 @@ LlmModelSettings MediapipeLlm::parseModelSettings(Runtime& runtime, const Object
         modelSettings.model_path = strdup(modelPath.c_str());
     }
     
+    // Also the engine's cache_dir, where MediaPipe keeps compiled GPU kernels
+    // and converted weights; the autotune results file lives beside them.
+    if (settings.hasProperty(runtime, "cacheDir")) {
+        auto cacheDir = settings.getProperty(runtime, "cacheDir").asString(runtime).utf8(runtime);
+        modelSettings.cache_dir = strdup(cacheDir.c_str());
+    }
+    
     if (settings.hasProperty(runtime, "maxNumTokens")) {
         modelSettings.max_num_tokens = static_cast<size_t>(settings.getProperty(runtime, "maxNumTokens").asNumber());
     } else {
@@ -275,10 +1609,21 @@ LlmModelSettings MediapipeLlm::parseModelSettings(Runtime& runtime, const Object
         );
     }
     
+    // LoRA ranks must be declared up front so the engine can reserve adapter
+    // slots; sessions then pick an adapter without reloading the base model.
+    if (settings.hasProperty(runtime, "supportedLoraRanks")) {
+        auto ranks = JSI_Helpers::getOptionalArray(runtime, settings, "supportedLoraRanks");
+        for (size_t i = 0; i < ranks.size(runtime); ++i) {
+            loraRanks.push_back(static_cast<size_t>(ranks.getValueAtIndex(runtime, i).asNumber()));
+        }
+        modelSettings.number_of_supported_lora_ranks = loraRanks.size();
+        modelSettings.supported_lora_ranks = loraRanks.data();
+    }
+    
     return modelSettings;
 }
 
-LlmSessionConfig MediapipeLlm::parseSessionConfig(Runtime& runtime, const Object& config) {
+LlmSessionConfig MediapipeLlm::parseSessionConfig(Runtime& runtime, const Object& config, std::shared_ptr<LoraAdapter>& loraAdapter) {
     LlmSessionConfig sessionConfig = {};
     
     if (config.hasProperty(runtime, "topK")) {
@@ -297,6 +1642,16 @@ LlmSessionConfig MediapipeLlm::parseSessionConfig(Runtime& runtime, const Object
         sessionConfig.random_seed = static_cast<size_t>(config.getProperty(runtime, "randomSeed").asNumber());
     }
     
+    std::string loraPath = JSI_Helpers::getOptionalString(runtime, config, "loraPath");
+    if (!loraPath.empty()) {
+        std::string error;
+        loraAdapter = loraAdapters_.acquire(loraPath, error);
+        if (!loraAdapter) {
+            throw JSError(runtime, "Failed to load LoRA adapter: " + error);
+        }
+        sessionConfig.lora_path = loraAdapter->path.c_str();
+    }
+    
     return sessionConfig;
 }
 
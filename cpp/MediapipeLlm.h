@@ -11,10 +11,18 @@
   #define HAS_JSI 0
 #endif
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <functional>
+#include <vector>
+#include "LoraAdapterRegistry.h"
+#include "Autotuner.h"
+#include "ThreadPlacement.h"
+#include "TokenStream.h"
+#include "TaskBundleInspector.h"
+#include "DraftPrefill.h"
 
 #if HAS_JSI
 extern "C" {
@@ -52,9 +60,13 @@ struct SessionWrapper {
     LlmInferenceEngine_Session* session;
     std::string sessionId;
     std::string engineId;
+    LlmSessionConfig config;
+    // The adapter the session was created with; keeps config.lora_path valid.
+    std::shared_ptr<LoraAdapter> loraAdapter;
     
-    SessionWrapper(LlmInferenceEngine_Session* sess, const std::string& id, const std::string& engId)
-        : session(sess), sessionId(id), engineId(engId) {}
+    SessionWrapper(LlmInferenceEngine_Session* sess, const std::string& id, const std::string& engId,
+                   const LlmSessionConfig& cfg, std::shared_ptr<LoraAdapter> adapter = nullptr)
+        : session(sess), sessionId(id), engineId(engId), config(cfg), loraAdapter(std::move(adapter)) {}
     
     ~SessionWrapper() {
         if (session) {
@@ -62,6 +74,44 @@ struct SessionWrapper {
         }
     }
 };
+
+// Candidates of one n-best request: clones of a single prefilled session,
+// each decoding into its own stream. Destroyed on the JS thread once every
+// stream has finished, which is after the last engine callback touches it;
+// streams JS has not drained yet outlive the group in streams_.
+struct NBestGroup {
+    std::string sessionId;  // the session the candidates were cloned from
+    std::vector<LlmInferenceEngine_Session*> sessions;
+    std::vector<std::shared_ptr<TokenStream>> streams;
+    std::vector<std::string> streamIds;
+    size_t stopAfter = 0;
+    std::atomic<size_t> completed{0};
+    // Set when a candidate ignored cancellation; its sessions are then leaked
+    // rather than deleted under the engine.
+    bool leakSessions = false;
+    
+    bool allFinished() const {
+        for (const auto& stream : streams) {
+            if (!stream->isFinished()) return false;
+        }
+        return true;
+    }
+    
+    ~NBestGroup() {
+        if (leakSessions) {
+            return;
+        }
+        for (auto* session : sessions) {
+            LlmInferenceEngine_Session_Delete(session);
+        }
+    }
+};
+
+// Which candidate of which n-best request a stream belongs to.
+struct NBestStreamRef {
+    std::string groupId;
+    size_t index = 0;
+};
 #endif
 
 class MediapipeLlm {
@@ -70,11 +120,30 @@ public:
     ~MediapipeLlm();
     
 #if HAS_JSI
+    // Runs a closure on the JS thread; used to wake JS when streamed output
+    // is ready. Without one, JS has to poll readStream.
+    using JsScheduler = std::function<void(std::function<void()>)>;
+    
     void install(Runtime& runtime);
+    void setJsScheduler(JsScheduler scheduler) { jsScheduler_ = std::move(scheduler); }
     
 private:
     std::unordered_map<std::string, std::unique_ptr<EngineWrapper>> engines_;
     std::unordered_map<std::string, std::unique_ptr<SessionWrapper>> sessions_;
+    LoraAdapterRegistry loraAdapters_;
+    JsScheduler jsScheduler_;
+    // Keyed by request ID; entries live until JS has drained a finished stream.
+    std::unordered_map<std::string, std::shared_ptr<TokenStream>> streams_;
+    std::unordered_map<std::string, std::string> streamSessions_;
+    std::unordered_map<std::string, std::shared_ptr<NBestGroup>> nbestGroups_;
+    std::unordered_map<std::string, NBestStreamRef> streamGroups_;
+    // Keyed by session ID; at most one draft is being typed per session.
+    // Dropped whenever the session itself changes, since the draft is built
+    // on a clone of it.
+    std::unordered_map<std::string, std::unique_ptr<DraftPrefill>> drafts_;
+    // Dropped drafts whose worker is still finishing a chunk, keyed by
+    // engine ID since their clones belong to the engine.
+    std::unordered_multimap<std::string, std::unique_ptr<DraftPrefill>> retiredDrafts_;
     
     std::string generateId();
     
@@ -84,17 +153,55 @@ private:
     Value deleteSession(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     Value updateRuntimeConfig(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     Value addQueryChunk(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value updateDraft(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value commitDraft(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value discardDraft(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     Value addImage(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     Value addAudio(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     Value predictSync(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     Value predictAsync(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     Value cloneSession(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     Value sizeInTokens(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value predictNBest(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value readStream(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value releaseNBest(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     Value cancelPendingProcess(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value swapLoraAdapter(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value getLoraAdapterStats(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value inspectModel(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value autotune(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value setThreadPolicy(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value getThreadStats(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value dumpLogs(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value setLogSink(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
+    Value getLogStats(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     Value multiply(Runtime& runtime, const Value& thisValue, const Value* arguments, size_t count);
     
-    LlmModelSettings parseModelSettings(Runtime& runtime, const Object& settings);
-    LlmSessionConfig parseSessionConfig(Runtime& runtime, const Object& config);
+    // Deletes an engine and its sessions, stopping requests still decoding.
+    void destroyEngine(const std::string& engineId);
+    bool hasActiveRequest(const std::string& sessionId) const;
+    // Cancels the session's own requests and forgets their streams; n-best
+    // groups cloned from it must be stopped first. Returns false if the
+    // engine did not wind one down in time; the session must then be leaked
+    // rather than deleted.
+    bool stopSessionRequests(const std::string& sessionId);
+    // Cancels an n-best request and frees its candidate sessions and streams.
+    // Returns false, leaking the candidates, if one did not stop in time.
+    bool stopNBestGroup(const std::string& groupId);
+    // Frees the candidate sessions of n-best requests that have finished.
+    void reapNBestGroups();
+    // Stops a session's draft without waiting for its worker, which would
+    // block the JS thread for up to a chunk of prefill.
+    void dropDraft(const std::string& sessionId);
+    // Frees dropped drafts whose worker has exited.
+    void reapDrafts();
+    
+    AutotuneConstraints parseAutotuneConstraints(Runtime& runtime, const Object& settingsObj, const LlmModelSettings& settings);
+    static AutotuneMeasurement benchmarkCandidate(const LlmModelSettings& settings, const AutotuneCandidate& candidate);
+    static Object createAutotuneObject(Runtime& runtime, const AutotuneResult& result);
+    
+    LlmModelSettings parseModelSettings(Runtime& runtime, const Object& settings, std::vector<size_t>& loraRanks);
+    LlmSessionConfig parseSessionConfig(Runtime& runtime, const Object& config, std::shared_ptr<LoraAdapter>& loraAdapter);
     SessionRuntimeConfig parseRuntimeConfig(Runtime& runtime, const Object& config);
     LlmPromptTemplates parsePromptTemplates(Runtime& runtime, const Object& templates);
     Object createResponseObject(Runtime& runtime, const LlmResponseContext& response);
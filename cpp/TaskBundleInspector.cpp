@@ -0,0 +1,556 @@
+#include "TaskBundleInspector.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace mediapipe_llm {
+
+namespace {
+
+// Runtime scratch, tokenizer and graph state not covered by weights or the
+// KV cache. Rough, but keeps estimates for small models from being optimistic.
+constexpr uint64_t kRuntimeOverheadBytes = 64ULL * 1024 * 1024;
+
+constexpr uint32_t kLocalHeaderSignature = 0x04034b50;
+constexpr uint32_t kCentralHeaderSignature = 0x02014b50;
+constexpr uint32_t kEndOfCentralDirSignature = 0x06054b50;
+constexpr uint32_t kZip64LocatorSignature = 0x07064b50;
+constexpr uint32_t kZip64EndOfCentralDirSignature = 0x06064b50;
+constexpr size_t kEndOfCentralDirSize = 22;
+constexpr size_t kMaxZipCommentSize = 0xFFFF;
+
+// Bounds-checked little-endian view over a byte range.
+class ByteView {
+public:
+    ByteView() = default;
+    ByteView(const uint8_t* data, uint64_t size) : data_(data), size_(size) {}
+
+    uint64_t size() const { return size_; }
+    const uint8_t* data() const { return data_; }
+
+    bool has(uint64_t offset, uint64_t length) const {
+        return offset <= size_ && length <= size_ - offset;
+    }
+
+    template <typename T>
+    bool read(uint64_t offset, T& out) const {
+        if (!has(offset, sizeof(T))) return false;
+        memcpy(&out, data_ + offset, sizeof(T));
+        return true;
+    }
+
+    ByteView sub(uint64_t offset, uint64_t length) const {
+        if (!has(offset, length)) return ByteView();
+        return ByteView(data_ + offset, length);
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    uint64_t size_ = 0;
+};
+
+class MappedFile {
+public:
+    ~MappedFile() {
+        if (data_) munmap(data_, size_);
+    }
+
+    bool open(const std::string& path, struct stat& st, std::string& error) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "Cannot open " + path + ": " + strerror(errno);
+            return false;
+        }
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            error = "Model file is empty or unreadable: " + path;
+            close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            error = "Cannot map " + path + ": " + strerror(errno);
+            return false;
+        }
+        data_ = mapped;
+        // Reads are scattered metadata lookups; readahead would pull in weights.
+        madvise(data_, size_, MADV_RANDOM);
+        return true;
+    }
+
+    ByteView view() const { return ByteView(static_cast<const uint8_t*>(data_), size_); }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// --- zip ---------------------------------------------------------------
+
+bool readZip64Extra(ByteView extra, uint32_t compressed32, uint32_t uncompressed32, uint32_t offset32,
+                    TaskBundleEntry& entry, uint64_t& localHeaderOffset) {
+    uint64_t pos = 0;
+    while (extra.has(pos, 4)) {
+        uint16_t id = 0;
+        uint16_t length = 0;
+        extra.read(pos, id);
+        extra.read(pos + 2, length);
+        ByteView field = extra.sub(pos + 4, length);
+        if (id == 0x0001) {
+            // Only the fields saturated in the fixed header are present, in order.
+            uint64_t fieldPos = 0;
+            if (uncompressed32 == 0xFFFFFFFF) {
+                if (!field.read(fieldPos, entry.uncompressedSize)) return false;
+                fieldPos += 8;
+            }
+            if (compressed32 == 0xFFFFFFFF) {
+                if (!field.read(fieldPos, entry.compressedSize)) return false;
+                fieldPos += 8;
+            }
+            if (offset32 == 0xFFFFFFFF) {
+                if (!field.read(fieldPos, localHeaderOffset)) return false;
+            }
+            return true;
+        }
+        pos += 4 + length;
+    }
+    return true;
+}
+
+bool readCentralDirectory(ByteView file, std::vector<TaskBundleEntry>& entries, std::string& error) {
+    if (file.size() < kEndOfCentralDirSize) {
+        error = "File too small to be a .task bundle";
+        return false;
+    }
+
+    // The end record sits in the last 22 bytes plus an optional comment.
+    uint64_t eocd = 0;
+    bool found = false;
+    uint64_t searchStart = file.size() - kEndOfCentralDirSize;
+    uint64_t searchEnd = searchStart > kMaxZipCommentSize ? searchStart - kMaxZipCommentSize : 0;
+    for (uint64_t pos = searchStart + 1; pos-- > searchEnd;) {
+        uint32_t signature = 0;
+        file.read(pos, signature);
+        if (signature == kEndOfCentralDirSignature) {
+            eocd = pos;
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        error = "Not a zip container (no end of central directory)";
+        return false;
+    }
+
+    uint16_t entryCount16 = 0;
+    uint32_t directorySize32 = 0;
+    uint32_t directoryOffset32 = 0;
+    file.read(eocd + 10, entryCount16);
+    file.read(eocd + 12, directorySize32);
+    file.read(eocd + 16, directoryOffset32);
+
+    uint64_t entryCount = entryCount16;
+    uint64_t directorySize = directorySize32;
+    uint64_t directoryOffset = directoryOffset32;
+
+    // Bundles over 4 GB use the zip64 end record.
+    uint32_t locatorSignature = 0;
+    if (eocd >= 20 && file.read(eocd - 20, locatorSignature) && locatorSignature == kZip64LocatorSignature) {
+        uint64_t zip64Eocd = 0;
+        uint32_t zip64Signature = 0;
+        if (!file.read(eocd - 20 + 8, zip64Eocd) || !file.read(zip64Eocd, zip64Signature) ||
+            zip64Signature != kZip64EndOfCentralDirSignature) {
+            error = "Corrupt zip64 end of central directory";
+            return false;
+        }
+        file.read(zip64Eocd + 32, entryCount);
+        file.read(zip64Eocd + 40, directorySize);
+        file.read(zip64Eocd + 48, directoryOffset);
+    }
+
+    ByteView directory = file.sub(directoryOffset, directorySize);
+    if (directory.size() != directorySize) {
+        error = "Central directory lies outside the file";
+        return false;
+    }
+
+    uint64_t pos = 0;
+    for (uint64_t i = 0; i < entryCount; ++i) {
+        uint32_t signature = 0;
+        uint16_t method = 0;
+        uint32_t compressed32 = 0;
+        uint32_t uncompressed32 = 0;
+        uint16_t nameLength = 0;
+        uint16_t extraLength = 0;
+        uint16_t commentLength = 0;
+        uint32_t offset32 = 0;
+        if (!directory.read(pos, signature) || signature != kCentralHeaderSignature ||
+            !directory.read(pos + 10, method) || !directory.read(pos + 20, compressed32) ||
+            !directory.read(pos + 24, uncompressed32) || !directory.read(pos + 28, nameLength) ||
+            !directory.read(pos + 30, extraLength) || !directory.read(pos + 32, commentLength) ||
+            !directory.read(pos + 42, offset32) || !directory.has(pos + 46, nameLength + extraLength)) {
+            error = "Corrupt central directory entry";
+            return false;
+        }
+
+        TaskBundleEntry entry;
+        entry.name.assign(reinterpret_cast<const char*>(directory.data() + pos + 46), nameLength);
+        entry.method = method;
+        entry.compressedSize = compressed32;
+        entry.uncompressedSize = uncompressed32;
+        uint64_t localHeaderOffset = offset32;
+        if (!readZip64Extra(directory.sub(pos + 46 + nameLength, extraLength), compressed32, uncompressed32,
+                            offset32, entry, localHeaderOffset)) {
+            error = "Corrupt zip64 extra field for " + entry.name;
+            return false;
+        }
+
+        // The local header repeats name and extra with possibly different
+        // lengths; it is the one page read next to entry data.
+        uint32_t localSignature = 0;
+        uint16_t localNameLength = 0;
+        uint16_t localExtraLength = 0;
+        if (!file.read(localHeaderOffset, localSignature) || localSignature != kLocalHeaderSignature ||
+            !file.read(localHeaderOffset + 26, localNameLength) ||
+            !file.read(localHeaderOffset + 28, localExtraLength)) {
+            error = "Corrupt local header for " + entry.name;
+            return false;
+        }
+        entry.dataOffset = localHeaderOffset + 30 + localNameLength + localExtraLength;
+
+        entries.push_back(entry);
+        pos += 46 + nameLength + extraLength + commentLength;
+    }
+
+    return true;
+}
+
+// --- protobuf (SentencePiece tokenizer) ---------------------------------
+
+bool readVarint(ByteView data, uint64_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = 0;
+        if (!data.read(pos++, byte)) return false;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// SentencePiece's ModelProto stores one `pieces` record (field 1) per token.
+int64_t countSentencePieces(ByteView model) {
+    int64_t pieces = 0;
+    uint64_t pos = 0;
+    while (pos < model.size()) {
+        uint64_t key = 0;
+        uint64_t value = 0;
+        if (!readVarint(model, pos, key)) return -1;
+        switch (key & 0x7) {
+            case 0:
+                if (!readVarint(model, pos, value)) return -1;
+                break;
+            case 1:
+                pos += 8;
+                break;
+            case 2:
+                if (!readVarint(model, pos, value) || !model.has(pos, value)) return -1;
+                pos += value;
+                if ((key >> 3) == 1) ++pieces;
+                break;
+            case 5:
+                pos += 4;
+                break;
+            default:
+                return -1;
+        }
+    }
+    return pieces;
+}
+
+// --- flatbuffers (TFLite model graph) -----------------------------------
+
+// Minimal accessor for the TFLite schema tables we need:
+//   Model.subgraphs = field 2, SubGraph.tensors = field 0,
+//   Tensor.shape = 0, Tensor.type = 1, Tensor.buffer = 2, Tensor.name = 3.
+class FlatTable {
+public:
+    FlatTable(ByteView buffer, uint64_t pos) : buffer_(buffer), pos_(pos) {
+        int32_t vtableOffset = 0;
+        if (!buffer_.read(pos_, vtableOffset)) return;
+        vtable_ = static_cast<uint64_t>(static_cast<int64_t>(pos_) - vtableOffset);
+        valid_ = buffer_.read(vtable_, vtableSize_);
+    }
+
+    bool valid() const { return valid_; }
+
+    // Absolute position of field `index`, or 0 if absent.
+    uint64_t field(int index) const {
+        uint16_t offset = 0;
+        uint64_t slot = 4 + 2 * static_cast<uint64_t>(index);
+        if (!valid_ || slot + 2 > vtableSize_ || !buffer_.read(vtable_ + slot, offset) || offset == 0) {
+            return 0;
+        }
+        return pos_ + offset;
+    }
+
+    // Follows a uoffset field to the vector it points at; returns its length.
+    uint64_t vector(int index, uint64_t& elements) const {
+        uint64_t at = field(index);
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        if (!at || !buffer_.read(at, offset) || !buffer_.read(at + offset, length)) {
+            return 0;
+        }
+        elements = at + offset + 4;
+        return buffer_.has(elements, static_cast<uint64_t>(length) * 4) || length == 0 ? length : 0;
+    }
+
+    FlatTable tableAt(uint64_t elementPos) const {
+        uint32_t offset = 0;
+        buffer_.read(elementPos, offset);
+        return FlatTable(buffer_, elementPos + offset);
+    }
+
+    std::string string(int index) const {
+        uint64_t chars = 0;
+        uint64_t at = field(index);
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        if (!at || !buffer_.read(at, offset) || !buffer_.read(at + offset, length)) return "";
+        chars = at + offset + 4;
+        if (!buffer_.has(chars, length)) return "";
+        return std::string(reinterpret_cast<const char*>(buffer_.data() + chars), length);
+    }
+
+    template <typename T>
+    T scalar(int index, T defaultValue) const {
+        uint64_t at = field(index);
+        T value = defaultValue;
+        if (at) buffer_.read(at, value);
+        return value;
+    }
+
+    const ByteView& buffer() const { return buffer_; }
+
+private:
+    ByteView buffer_;
+    uint64_t pos_;
+    uint64_t vtable_ = 0;
+    uint16_t vtableSize_ = 0;
+    bool valid_ = false;
+};
+
+// Bits per element by TFLite TensorType value; 0 for types we don't size.
+int tensorTypeBits(int8_t type) {
+    switch (type) {
+        case 0: return 32;   // FLOAT32
+        case 1: return 16;   // FLOAT16
+        case 2: return 32;   // INT32
+        case 3: return 8;    // UINT8
+        case 4: return 64;   // INT64
+        case 7: return 16;   // INT16
+        case 9: return 8;    // INT8
+        case 10: return 64;  // FLOAT64
+        case 17: return 4;   // INT4
+        case 18: return 16;  // BFLOAT16
+        default: return 0;
+    }
+}
+
+const char* tensorTypeName(int8_t type) {
+    switch (type) {
+        case 0: return "float32";
+        case 1: return "float16";
+        case 3: return "uint8";
+        case 7: return "int16";
+        case 9: return "int8";
+        case 17: return "int4";
+        case 18: return "bfloat16";
+        default: return "unknown";
+    }
+}
+
+void inspectGraph(ByteView model, ModelCapabilities& caps) {
+    uint32_t rootOffset = 0;
+    if (!model.read(0, rootOffset)) return;
+
+    FlatTable root(model, rootOffset);
+    if (!root.valid()) return;
+
+    std::map<int8_t, uint64_t> weightElementsByType;
+
+    uint64_t subgraphs = 0;
+    uint64_t subgraphCount = root.vector(2, subgraphs);
+    for (uint64_t s = 0; s < subgraphCount; ++s) {
+        FlatTable subgraph = root.tableAt(subgraphs + 4 * s);
+        if (!subgraph.valid()) continue;
+
+        uint64_t tensors = 0;
+        uint64_t tensorCount = subgraph.vector(0, tensors);
+        for (uint64_t t = 0; t < tensorCount; ++t) {
+            FlatTable tensor = subgraph.tableAt(tensors + 4 * t);
+            if (!tensor.valid()) continue;
+
+            uint64_t dims = 0;
+            uint64_t rank = tensor.vector(0, dims);
+            uint64_t elements = 1;
+            std::vector<int32_t> shape;
+            for (uint64_t d = 0; d < rank; ++d) {
+                int32_t dim = 0;
+                model.read(dims + 4 * d, dim);
+                shape.push_back(dim);
+                elements *= dim > 0 ? static_cast<uint64_t>(dim) : 1;
+            }
+
+            int8_t type = tensor.scalar<int8_t>(1, 0);
+            uint32_t buffer = tensor.scalar<uint32_t>(2, 0);
+            std::string name = tensor.string(3);
+
+            // Converted LLMs expose the cache as kv_cache_{k,v}_<layer>
+            // inputs shaped [batch, max_seq_len, kv_heads, head_dim]. Every
+            // signature references the same tensors, so count the first
+            // subgraph only.
+            if (name.find("kv_cache") != std::string::npos && rank == 4) {
+                if (shape[1] > caps.contextLength) {
+                    caps.contextLength = shape[1];
+                }
+                if (s == 0) {
+                    caps.kvCacheBytes += elements * tensorTypeBits(type) / 8;
+                }
+            } else if (buffer != 0 && rank >= 2) {
+                weightElementsByType[type] += elements;
+            }
+        }
+    }
+
+    uint64_t dominant = 0;
+    for (const auto& entry : weightElementsByType) {
+        if (entry.second > dominant) {
+            dominant = entry.second;
+            caps.weightType = tensorTypeName(entry.first);
+        }
+    }
+}
+
+// --- cache --------------------------------------------------------------
+
+std::mutex cacheMutex;
+std::unordered_map<std::string, std::shared_ptr<const ModelCapabilities>> cache;
+
+std::string fileIdentity(const struct stat& st) {
+#ifdef __APPLE__
+    auto mtimeNs = static_cast<long long>(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    auto mtimeNs = static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+    return std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino) + ":" +
+           std::to_string(st.st_size) + ":" + std::to_string(mtimeNs);
+}
+
+bool startsWith(const std::string& value, const char* prefix) {
+    return value.compare(0, strlen(prefix), prefix) == 0;
+}
+
+} // namespace
+
+std::shared_ptr<const ModelCapabilities> TaskBundleInspector::inspect(const std::string& path) {
+    auto caps = std::make_shared<ModelCapabilities>();
+
+    struct stat st = {};
+    if (stat(path.c_str(), &st) != 0) {
+        caps->error = "Model file does not exist: " + path;
+        return caps;
+    }
+
+    std::string identity = fileIdentity(st);
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(identity);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+
+    MappedFile file;
+    if (!file.open(path, st, caps->error)) {
+        return caps;
+    }
+    ByteView view = file.view();
+    inspectBytes(view.data(), view.size(), *caps);
+    if (!caps->ok) {
+        return caps;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache[identity] = caps;
+    return caps;
+}
+
+void TaskBundleInspector::clearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.clear();
+}
+
+void TaskBundleInspector::inspectBytes(const uint8_t* data, uint64_t size, ModelCapabilities& caps) {
+    ByteView view(data, size);
+    caps.fileSizeBytes = view.size();
+
+    if (!readCentralDirectory(view, caps.entries, caps.error)) {
+        return;
+    }
+
+    bool hasGraph = false;
+    for (const auto& entry : caps.entries) {
+        if (entry.name.find("VISION") != std::string::npos) caps.supportsVision = true;
+        if (entry.name.find("AUDIO") != std::string::npos) caps.supportsAudio = true;
+
+        if (startsWith(entry.name, "TF_LITE_")) {
+            caps.weightBytes += entry.uncompressedSize;
+            hasGraph = true;
+        }
+
+        // Compressed members can't be read in place; the bundler stores
+        // models uncompressed so they can be mapped by the engine as well.
+        if (entry.method != 0) continue;
+        ByteView member = view.sub(entry.dataOffset, entry.uncompressedSize);
+        if (member.size() != entry.uncompressedSize) continue;
+
+        if (entry.name == "TOKENIZER_MODEL") {
+            caps.vocabSize = countSentencePieces(member);
+        } else if (entry.name == "TF_LITE_PREFILL_DECODE") {
+            inspectGraph(member, caps);
+        }
+    }
+
+    // Any zip parses this far; without a graph it is not an LLM bundle.
+    if (!hasGraph) {
+        caps.error = "Not a .task bundle: no TF_LITE_* model graph";
+        return;
+    }
+
+    caps.estimatedMemoryBytes = caps.weightBytes + caps.kvCacheBytes + kRuntimeOverheadBytes;
+    caps.ok = true;
+}
+
+bool TaskBundleInspector::parseZipDirectory(const uint8_t* data, uint64_t size, std::vector<TaskBundleEntry>& entries,
+                                            std::string& error) {
+    return readCentralDirectory(ByteView(data, size), entries, error);
+}
+
+int64_t TaskBundleInspector::countTokenizerPieces(const uint8_t* data, uint64_t size) {
+    return countSentencePieces(ByteView(data, size));
+}
+
+void TaskBundleInspector::parseModelGraph(const uint8_t* data, uint64_t size, ModelCapabilities& caps) {
+    inspectGraph(ByteView(data, size), caps);
+}
+
+} // namespace mediapipe_llm
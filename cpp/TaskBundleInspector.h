@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mediapipe_llm {
+
+struct TaskBundleEntry {
+    std::string name;
+    uint64_t dataOffset = 0;  // start of the entry's data within the file
+    uint64_t compressedSize = 0;
+    uint64_t uncompressedSize = 0;
+    uint16_t method = 0;  // 0 = stored, 8 = deflate
+};
+
+struct ModelCapabilities {
+    bool ok = false;
+    std::string error;
+
+    std::vector<TaskBundleEntry> entries;
+
+    // -1 when the bundle does not say.
+    int64_t contextLength = -1;
+    int64_t vocabSize = -1;
+
+    bool supportsVision = false;
+    bool supportsAudio = false;
+
+    // Dominant type of the constant weight tensors: "int4", "int8",
+    // "float16", "float32", ... or "unknown".
+    std::string weightType = "unknown";
+
+    uint64_t fileSizeBytes = 0;
+    uint64_t weightBytes = 0;
+    uint64_t kvCacheBytes = 0;
+    uint64_t estimatedMemoryBytes = 0;
+};
+
+// Reads what a .task bundle can do without loading it. The file is mapped,
+// not read: only the zip central directory, the tokenizer and the flatbuffer
+// tables of the model graph are touched, never the weight pages.
+class TaskBundleInspector {
+public:
+    // Results are cached by file identity (device, inode, size, mtime), so a
+    // replaced file is re-inspected and a renamed one is not.
+    static std::shared_ptr<const ModelCapabilities> inspect(const std::string& path);
+
+    static void clearCache();
+
+    // The parsers behind inspect(), over bytes already in memory. They never
+    // touch the filesystem, so they can be checked against hand-built input.
+    static void inspectBytes(const uint8_t* data, uint64_t size, ModelCapabilities& caps);
+    static bool parseZipDirectory(const uint8_t* data, uint64_t size, std::vector<TaskBundleEntry>& entries,
+                                  std::string& error);
+    // Number of pieces in a SentencePiece ModelProto, or -1 if malformed.
+    static int64_t countTokenizerPieces(const uint8_t* data, uint64_t size);
+    static void parseModelGraph(const uint8_t* data, uint64_t size, ModelCapabilities& caps);
+};
+
+} // namespace mediapipe_llm
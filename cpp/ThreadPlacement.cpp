@@ -0,0 +1,329 @@
+#include "ThreadPlacement.h"
+#include <algorithm>
+#include <ctime>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#if defined(__APPLE__)
+#include <pthread/qos.h>
+#endif
+
+namespace mediapipe_llm {
+
+namespace {
+
+double timespecSeconds(const struct timespec& ts) {
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int niceForRole(const ThreadPolicy& policy, ThreadRole role) {
+    switch (role) {
+        case ThreadRole::Decode: return policy.decodeNice;
+        case ThreadRole::Background: return policy.backgroundNice;
+    }
+    return 0;
+}
+
+#if defined(__linux__)
+// CPU time and start time of one of this process's threads, by TID. Works on
+// threads other than the caller and fails cleanly once the thread is gone.
+bool readTaskStat(uint64_t tid, double& cpuSeconds, uint64_t& startTicks) {
+    std::ifstream file("/proc/self/task/" + std::to_string(tid) + "/stat");
+    std::string line;
+    if (!std::getline(file, line)) {
+        return false;
+    }
+
+    // The command name may contain spaces; fields resume after its last ')'.
+    size_t nameEnd = line.rfind(')');
+    if (nameEnd == std::string::npos) {
+        return false;
+    }
+    std::istringstream rest(line.substr(nameEnd + 1));
+    std::vector<std::string> fields;  // fields[0] is field 3 (state)
+    std::string field;
+    while (fields.size() < 20 && rest >> field) {
+        fields.push_back(field);
+    }
+    if (fields.size() < 20) {
+        return false;
+    }
+
+    static const double ticksPerSecond = static_cast<double>(sysconf(_SC_CLK_TCK));
+    unsigned long long utime = strtoull(fields[11].c_str(), nullptr, 10);
+    unsigned long long stime = strtoull(fields[12].c_str(), nullptr, 10);
+    cpuSeconds = (utime + stime) / ticksPerSecond;
+    startTicks = strtoull(fields[19].c_str(), nullptr, 10);
+    return true;
+}
+#endif
+
+#if defined(__APPLE__)
+qos_class_t qosForNice(int nice) {
+    if (nice < 0) return QOS_CLASS_USER_INITIATED;
+    if (nice == 0) return QOS_CLASS_DEFAULT;
+    if (nice < 10) return QOS_CLASS_UTILITY;
+    return QOS_CLASS_BACKGROUND;
+}
+#endif
+
+// The calling thread's priority and affinity from before its first
+// placement; put back on release.
+struct SavedPlacement {
+    bool saved = false;
+#if defined(__linux__)
+    int nice = 0;
+    bool hasAffinity = false;
+    cpu_set_t affinity;
+#elif defined(__APPLE__)
+    qos_class_t qos = QOS_CLASS_UNSPECIFIED;
+#endif
+};
+
+thread_local SavedPlacement savedPlacement;
+
+void savePlacement() {
+    if (savedPlacement.saved) {
+        return;
+    }
+#if defined(__linux__)
+    savedPlacement.nice = getpriority(PRIO_PROCESS, static_cast<id_t>(currentThreadId()));
+    savedPlacement.hasAffinity =
+        sched_getaffinity(0, sizeof(savedPlacement.affinity), &savedPlacement.affinity) == 0;
+#elif defined(__APPLE__)
+    pthread_get_qos_class_np(pthread_self(), &savedPlacement.qos, nullptr);
+#endif
+    savedPlacement.saved = true;
+}
+
+void restoreAffinity() {
+#if defined(__linux__)
+    if (savedPlacement.saved && savedPlacement.hasAffinity) {
+        sched_setaffinity(0, sizeof(savedPlacement.affinity), &savedPlacement.affinity);
+    }
+#endif
+}
+
+void restorePlacement() {
+    if (!savedPlacement.saved) {
+        return;
+    }
+    restoreAffinity();
+#if defined(__linux__)
+    setpriority(PRIO_PROCESS, static_cast<id_t>(currentThreadId()), savedPlacement.nice);
+#elif defined(__APPLE__)
+    pthread_set_qos_class_self_np(savedPlacement.qos, 0);
+#endif
+    savedPlacement.saved = false;
+}
+
+void applyPriority(int nice) {
+#if defined(__linux__)
+    // On Linux nice is per thread when addressed by TID.
+    setpriority(PRIO_PROCESS, static_cast<id_t>(currentThreadId()), nice);
+#elif defined(__APPLE__)
+    pthread_set_qos_class_self_np(qosForNice(nice), 0);
+#endif
+}
+
+void applyAffinity(const std::vector<int>& cores) {
+#if defined(__linux__)
+    if (cores.empty()) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int core : cores) {
+        CPU_SET(core, &set);
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+#else
+    // iOS and macOS do not expose core affinity; QoS steers placement instead.
+    (void)cores;
+#endif
+}
+
+} // namespace
+
+uint64_t currentThreadId() {
+#if defined(__linux__)
+    return static_cast<uint64_t>(syscall(SYS_gettid));
+#elif defined(__APPLE__)
+    uint64_t tid = 0;
+    pthread_threadid_np(nullptr, &tid);
+    return tid;
+#else
+    return reinterpret_cast<uint64_t>(pthread_self());
+#endif
+}
+
+const char* threadRoleName(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::Decode: return "decode";
+        case ThreadRole::Background: return "background";
+    }
+    return "unknown";
+}
+
+ThreadPlacement& ThreadPlacement::shared() {
+    static ThreadPlacement instance;
+    return instance;
+}
+
+ThreadPlacement::ThreadPlacement() : topology_(readTopology()) {}
+
+CoreTopology ThreadPlacement::readTopology() {
+    CoreTopology topology;
+
+    long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+    for (long cpu = 0; cpu < cpuCount; ++cpu) {
+        std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/cpuinfo_max_freq");
+        long freq = 0;
+        file >> freq;
+        topology.maxFreqKHz.push_back(freq);
+    }
+
+    if (topology.maxFreqKHz.empty()) {
+        return topology;
+    }
+
+    // Everything clocked above the slowest cluster counts as a performance
+    // core, which groups prime and big cores together on tri-cluster SoCs.
+    long slowest = *std::min_element(topology.maxFreqKHz.begin(), topology.maxFreqKHz.end());
+    long fastest = *std::max_element(topology.maxFreqKHz.begin(), topology.maxFreqKHz.end());
+    if (slowest <= 0 || slowest == fastest) {
+        return topology;
+    }
+
+    for (size_t cpu = 0; cpu < topology.maxFreqKHz.size(); ++cpu) {
+        if (topology.maxFreqKHz[cpu] > slowest) {
+            topology.performanceCores.push_back(static_cast<int>(cpu));
+        } else {
+            topology.efficiencyCores.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    return topology;
+}
+
+double ThreadPlacement::currentThreadCpuSeconds(uint64_t& startTicks) {
+    startTicks = 0;
+#if defined(__linux__)
+    // Same source as stats() samples other threads from, so the deltas agree.
+    double cpuSeconds = 0.0;
+    if (readTaskStat(currentThreadId(), cpuSeconds, startTicks)) {
+        return cpuSeconds;
+    }
+#endif
+    struct timespec ts = {};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0.0;
+    }
+    return timespecSeconds(ts);
+}
+
+void ThreadPlacement::setPolicy(const ThreadPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+}
+
+ThreadPolicy ThreadPlacement::policy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_;
+}
+
+void ThreadPlacement::placeCurrentThread(ThreadRole role) {
+    ThreadPolicy policy = this->policy();
+
+    savePlacement();
+    applyPriority(niceForRole(policy, role));
+
+    // A thread pinned under an earlier policy or role is unpinned here.
+    if (topology_.isHeterogeneous() && role == ThreadRole::Decode && policy.pinDecodeToPerformanceCores) {
+        applyAffinity(topology_.performanceCores);
+    } else if (topology_.isHeterogeneous() && role == ThreadRole::Background && policy.pinBackgroundToEfficiencyCores) {
+        applyAffinity(topology_.efficiencyCores);
+    } else {
+        restoreAffinity();
+    }
+
+    uint64_t tid = currentThreadId();
+    uint64_t startTicks = 0;
+    double cpuSeconds = currentThreadCpuSeconds(startTicks);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = threads_.find(tid);
+    if (it != threads_.end()) {
+        // Re-placed: bill the time so far to the old role. A record left by
+        // an exited thread whose TID we now have only keeps its last sample.
+        double until = it->second.startTicks == startTicks ? cpuSeconds : it->second.lastCpuSeconds;
+        finishedCpuSeconds_[static_cast<int>(it->second.role)] += until - it->second.cpuSecondsAtPlacement;
+    }
+    threads_[tid] = ThreadRecord{role, startTicks, cpuSeconds, cpuSeconds};
+}
+
+void ThreadPlacement::releaseCurrentThread() {
+    restorePlacement();
+
+    uint64_t tid = currentThreadId();
+    uint64_t startTicks = 0;
+    double cpuSeconds = currentThreadCpuSeconds(startTicks);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = threads_.find(tid);
+    if (it == threads_.end()) {
+        return;
+    }
+    double until = it->second.startTicks == startTicks ? cpuSeconds : it->second.lastCpuSeconds;
+    finishedCpuSeconds_[static_cast<int>(it->second.role)] += until - it->second.cpuSecondsAtPlacement;
+    threads_.erase(it);
+}
+
+std::vector<ThreadCpuStats> ThreadPlacement::stats() {
+    std::vector<ThreadCpuStats> result;
+    for (ThreadRole role : {ThreadRole::Decode, ThreadRole::Background}) {
+        ThreadCpuStats entry;
+        entry.role = role;
+        result.push_back(entry);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (auto& entry : result) {
+        entry.cpuSeconds = finishedCpuSeconds_[static_cast<int>(entry.role)];
+    }
+
+    for (auto it = threads_.begin(); it != threads_.end();) {
+        auto& stats = result[static_cast<int>(it->second.role)];
+#if defined(__linux__)
+        // Threads owned by the inference engine can exit without releasing;
+        // they are retired here with the last CPU time seen while alive.
+        double cpuSeconds = 0.0;
+        uint64_t startTicks = 0;
+        if (!readTaskStat(it->first, cpuSeconds, startTicks) || startTicks != it->second.startTicks) {
+            double spent = it->second.lastCpuSeconds - it->second.cpuSecondsAtPlacement;
+            finishedCpuSeconds_[static_cast<int>(it->second.role)] += spent;
+            stats.cpuSeconds += spent;
+            it = threads_.erase(it);
+            continue;
+        }
+        it->second.lastCpuSeconds = cpuSeconds;
+#endif
+        // Off Linux only a thread's own clock is readable, so a live thread
+        // shows up in the totals once it releases.
+        stats.cpuSeconds += it->second.lastCpuSeconds - it->second.cpuSecondsAtPlacement;
+        ++stats.threads;
+        ++it;
+    }
+
+    return result;
+}
+
+} // namespace mediapipe_llm
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mediapipe_llm {
+
+// What a native thread is doing, which decides its cores and priority.
+enum class ThreadRole {
+    Decode,      // token generation the user is waiting on
+    Background,  // speculative or housekeeping work
+};
+
+const char* threadRoleName(ThreadRole role);
+
+// OS-level ID of the calling thread: the TID on Linux and Android, the
+// system-wide thread ID on Apple platforms.
+uint64_t currentThreadId();
+
+struct ThreadPolicy {
+    bool pinDecodeToPerformanceCores = false;
+    bool pinBackgroundToEfficiencyCores = false;
+    // Linux nice values; mapped onto QoS classes on Apple platforms.
+    int decodeNice = -4;
+    int backgroundNice = 10;
+};
+
+struct CoreTopology {
+    std::vector<long> maxFreqKHz;  // indexed by CPU number, 0 if unknown
+    std::vector<int> performanceCores;
+    std::vector<int> efficiencyCores;
+
+    // False on homogeneous CPUs or when sysfs is unreadable; pinning is then
+    // skipped because there is nothing to gain from it.
+    bool isHeterogeneous() const { return !performanceCores.empty() && !efficiencyCores.empty(); }
+};
+
+struct ThreadCpuStats {
+    ThreadRole role;
+    size_t threads = 0;
+    double cpuSeconds = 0.0;
+};
+
+// Places inference threads on cores by role and keeps CPU-time accounting for
+// every thread it has placed. Placement is best effort: failures to change
+// affinity or priority (e.g. missing permissions) are silently ignored.
+//
+// Only threads that run our code can be placed: the engine's callback thread
+// while it delivers a request's tokens, and the draft prefill workers.
+// MediaPipe's compute threads (the XNNPACK pool, GPU command threads) are not
+// reachable through its C API, and prefill runs before the first callback.
+// Pinning decode therefore moves the thread that coordinates decoding and
+// streams its output, not the matrix work itself.
+class ThreadPlacement {
+public:
+    static ThreadPlacement& shared();
+
+    void setPolicy(const ThreadPolicy& policy);
+    ThreadPolicy policy() const;
+    const CoreTopology& topology() const { return topology_; }
+
+    // Applies the policy for `role` to the calling thread and starts
+    // accounting its CPU time. Safe to call repeatedly; a role that is not
+    // pinned gets back the affinity the thread had before it was placed.
+    void placeCurrentThread(ThreadRole role);
+
+    // Stops accounting the calling thread, folding its CPU time into the
+    // totals for the role it was placed under, and restores the priority and
+    // affinity it had before placement. Threads that exit without releasing
+    // keep the CPU time last sampled by stats().
+    void releaseCurrentThread();
+
+    std::vector<ThreadCpuStats> stats();
+
+private:
+    struct ThreadRecord {
+        ThreadRole role;
+        uint64_t startTicks;  // tells the placed thread from a later one reusing its TID
+        double cpuSecondsAtPlacement;
+        double lastCpuSeconds;
+    };
+
+    ThreadPlacement();
+
+    static CoreTopology readTopology();
+    static double currentThreadCpuSeconds(uint64_t& startTicks);
+
+    const CoreTopology topology_;
+
+    mutable std::mutex mutex_;
+    ThreadPolicy policy_;
+    std::unordered_map<uint64_t, ThreadRecord> threads_;
+    std::unordered_map<int, double> finishedCpuSeconds_;
+};
+
+} // namespace mediapipe_llm
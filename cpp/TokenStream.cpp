@@ -0,0 +1,120 @@
+#include "TokenStream.h"
+
+namespace mediapipe_llm {
+
+namespace {
+
+// A zero limit could never be got under, so the producer would park forever.
+TokenStreamOptions withUsableLimit(TokenStreamOptions options) {
+    if (options.highWaterBytes == 0) {
+        options.highWaterBytes = 1;
+    }
+    return options;
+}
+
+} // namespace
+
+TokenStream::TokenStream(const TokenStreamOptions& options, NotifyFn notify)
+    : options_(withUsableLimit(options)),
+      notify_(std::move(notify)),
+      // Backdated so the first token is delivered without waiting an interval.
+      lastNotify_(std::chrono::steady_clock::now() - options.notifyInterval) {}
+
+bool TokenStream::append(const char* data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (unread_.size() >= options_.highWaterBytes && !cancelled_) {
+        ++stats_.backpressureWaits;
+        // Make sure the consumer knows there is something to drain before
+        // parking, or both sides could wait on each other.
+        maybeNotifyLocked(lock, true);
+        drained_.wait(lock, [this] { return unread_.size() < options_.highWaterBytes || cancelled_; });
+    }
+
+    if (cancelled_) {
+        return false;
+    }
+
+    unread_.append(data, size);
+    stats_.bytesWritten += size;
+    maybeNotifyLocked(lock, false);
+
+    return true;
+}
+
+void TokenStream::finish(const std::string& error) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_ = true;
+    error_ = error;
+    finishedCv_.notify_all();
+    // The final batch is always delivered without waiting out the interval.
+    maybeNotifyLocked(lock, true);
+}
+
+void TokenStream::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+    }
+    drained_.notify_all();
+}
+
+std::string TokenStream::take(bool& finished) {
+    std::string out;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.swap(unread_);
+        finished = finished_;
+        stats_.bytesRead += out.size();
+        notifyPending_ = false;
+    }
+    drained_.notify_all();
+    return out;
+}
+
+bool TokenStream::waitFinished(std::chrono::steady_clock::time_point deadline) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return finishedCv_.wait_until(lock, deadline, [this] { return finished_; });
+}
+
+bool TokenStream::isFinished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return finished_;
+}
+
+bool TokenStream::isCancelled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_;
+}
+
+std::string TokenStream::error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+}
+
+TokenStreamStats TokenStream::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void TokenStream::maybeNotifyLocked(std::unique_lock<std::mutex>& lock, bool force) {
+    if (notifyPending_ || !notify_) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - lastNotify_ < options_.notifyInterval) {
+        return;
+    }
+
+    notifyPending_ = true;
+    lastNotify_ = now;
+    ++stats_.notifications;
+
+    // Never call out while holding the lock; the notifier may take() inline.
+    lock.unlock();
+    notify_();
+    lock.lock();
+}
+
+} // namespace mediapipe_llm
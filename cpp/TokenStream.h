@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace mediapipe_llm {
+
+struct TokenStreamOptions {
+    // Minimum spacing between wake-ups of the consumer; one 60 Hz frame.
+    std::chrono::milliseconds notifyInterval{16};
+    // Unread bytes at which the producer blocks until the consumer catches up.
+    // Zero is taken as 1: every append then waits for the last to be drained.
+    size_t highWaterBytes = 64 * 1024;
+};
+
+struct TokenStreamStats {
+    uint64_t bytesWritten = 0;
+    uint64_t bytesRead = 0;
+    uint64_t notifications = 0;
+    uint64_t backpressureWaits = 0;
+};
+
+// Per-request buffer of decoded text shared between the decode thread and JS.
+//
+// The producer appends as tokens arrive; the consumer drains everything
+// unread in one go. The consumer is woken at most once per notify interval,
+// and not again until it has drained the previous batch, so a fast decoder
+// costs the JS thread one wake-up per frame rather than one per token. Text
+// that arrives inside the interval rides along with the next token.
+class TokenStream {
+public:
+    using NotifyFn = std::function<void()>;
+
+    TokenStream(const TokenStreamOptions& options, NotifyFn notify);
+
+    // Producer side. `append` blocks while the consumer is more than
+    // highWaterBytes behind; returns false once the stream is cancelled.
+    bool append(const char* data, size_t size);
+    void finish(const std::string& error = "");
+
+    // Wakes a blocked producer and makes further appends fail. The producer
+    // still calls finish() when it winds down.
+    void cancel();
+
+    // Consumer side. Moves all unread bytes out of the stream; `finished` is
+    // set when nothing more will ever follow them. A cancelled stream only
+    // reports finished once the producer has called finish(), so the
+    // consumer never frees state the producer is still using.
+    std::string take(bool& finished);
+
+    // Blocks until the producer has called finish() or `deadline` passes;
+    // returns whether it finished.
+    bool waitFinished(std::chrono::steady_clock::time_point deadline) const;
+
+    bool isFinished() const;
+    bool isCancelled() const;
+    std::string error() const;
+    TokenStreamStats stats() const;
+
+private:
+    void maybeNotifyLocked(std::unique_lock<std::mutex>& lock, bool force);
+
+    const TokenStreamOptions options_;
+    const NotifyFn notify_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable drained_;
+    mutable std::condition_variable finishedCv_;
+    std::string unread_;
+    std::string error_;
+    bool finished_ = false;
+    bool cancelled_ = false;
+    bool notifyPending_ = false;
+    std::chrono::steady_clock::time_point lastNotify_;
+    TokenStreamStats stats_;
+};
+
+} // namespace mediapipe_llm
@@ -1,11 +1,9 @@
 #include <jni.h>
+#include <chrono>
+#include <cstring>
 #include <string>
-#include <android/log.h>
 #include "../MediapipeLlm.h"
-
-#define LOG_TAG "MediapipeLlm"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#include "../Logger.h"
 
 // External function declarations from stub
 extern "C" {
@@ -26,11 +24,18 @@ Java_com_reactnativemediapipellm_MediapipeLlmModule_nativeCreateEngine(
 ) {
     const char* model_path_c = env->GetStringUTFChars(modelPath, nullptr);
     
-    LOGI("Creating LLM engine with model: %s", model_path_c);
+    auto start = std::chrono::steady_clock::now();
     
     // Call the stub implementation
     void* engine = LlmInferenceEngineCreate(model_path_c);
     
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    if (engine) {
+        LLM_LOGI(EngineCreate, strlen(model_path_c), elapsedMs);
+    } else {
+        LLM_LOGE(EngineCreateFailed, elapsedMs);
+    }
+    
     env->ReleaseStringUTFChars(modelPath, model_path_c);
     
     return reinterpret_cast<jlong>(engine);
@@ -45,11 +50,16 @@ Java_com_reactnativemediapipellm_MediapipeLlmModule_nativeGenerateResponse(
 ) {
     const char* prompt_c = env->GetStringUTFChars(prompt, nullptr);
     
-    LOGI("Generating response for prompt: %s", prompt_c);
+    // Sizes only: prompts are user content and never reach the log.
+    LLM_LOGI(Generate, strlen(prompt_c));
+    auto start = std::chrono::steady_clock::now();
     
     void* engine = reinterpret_cast<void*>(enginePtr);
     const char* response = LlmInferenceEngineGenerateResponse(engine, prompt_c);
     
+    LLM_LOGI(GenerateDone, response ? strlen(response) : 0,
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+    
     env->ReleaseStringUTFChars(prompt, prompt_c);
     
     return env->NewStringUTF(response);
@@ -61,7 +71,7 @@ Java_com_reactnativemediapipellm_MediapipeLlmModule_nativeDeleteEngine(
     jobject thiz, 
     jlong enginePtr
 ) {
-    LOGI("Deleting LLM engine");
+    LLM_LOGI(EngineDelete);
     
     void* engine = reinterpret_cast<void*>(enginePtr);
     LlmInferenceEngineDelete(engine);
@@ -150,18 +160,25 @@ Java_com_reactnativemediapipellm_MediapipeLlmModule_nativeGenerateResponse(
         }
         
         // Generate response
+        LLM_LOGI(Generate, strlen(prompt_str));
+        auto start = std::chrono::steady_clock::now();
+        
         LlmResponseContext response = {};
         result = LlmInferenceEngine_Session_PredictSync(session, &response, &error_msg);
         
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        
         env->ReleaseStringUTFChars(engine_id, id_str);
         env->ReleaseStringUTFChars(prompt, prompt_str);
         
         if (result == 0 && response.response_array && response.response_count > 0) {
+            LLM_LOGI(GenerateDone, strlen(response.response_array[0]), elapsedMs);
             jstring response_str = env->NewStringUTF(response.response_array[0]);
             LlmInferenceEngine_CloseResponseContext(&response);
             LlmInferenceEngine_Session_Delete(session);
             return response_str;
         } else {
+            LLM_LOGE(GenerateFailed, elapsedMs);
             LlmInferenceEngine_Session_Delete(session);
             jstring error = env->NewStringUTF(error_msg ? error_msg : "Generation failed");
             if (error_msg) {
@@ -191,19 +208,57 @@ Java_com_reactnativemediapipellm_MediapipeLlmModule_nativeDeleteEngine(
         if (engine) {
             LlmInferenceEngine_Engine_Delete(engine);
         }
-    } catch (const std::exception& e) {
-        LOGE("Error deleting engine: %s", e.what());
+    } catch (const std::exception&) {
+        LLM_LOGE(EngineDeleteFailed);
     }
     
     env->ReleaseStringUTFChars(engine_id, id_str);
 }
 
+// JNI method backing ModelLoader.inspectModel; returns null if the bundle
+// can't be parsed.
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_reactnativemediapipellm_ModelLoader_nativeInspectModel(
+    JNIEnv *env, jobject thiz, jstring model_path) {
+    
+    const char *path = env->GetStringUTFChars(model_path, nullptr);
+    auto caps = mediapipe_llm::TaskBundleInspector::inspect(path);
+    env->ReleaseStringUTFChars(model_path, path);
+    
+    if (!caps->ok) {
+        LLM_LOGW(ModelInspectFailed);
+        return nullptr;
+    }
+    
+    char json[512];
+    snprintf(json, sizeof(json),
+        "{\"contextLength\":%lld,\"vocabSize\":%lld,\"supportsVision\":%s,\"supportsAudio\":%s,"
+        "\"weightType\":\"%s\",\"weightBytes\":%llu,\"kvCacheBytes\":%llu,\"estimatedMemoryBytes\":%llu}",
+        static_cast<long long>(caps->contextLength), static_cast<long long>(caps->vocabSize),
+        caps->supportsVision ? "true" : "false", caps->supportsAudio ? "true" : "false",
+        caps->weightType.c_str(), static_cast<unsigned long long>(caps->weightBytes),
+        static_cast<unsigned long long>(caps->kvCacheBytes),
+        static_cast<unsigned long long>(caps->estimatedMemoryBytes));
+    
+    return env->NewStringUTF(json);
+}
+
+// JNI method backing MediapipeLlmModule.dumpNativeLogs: the most recent
+// native log records, one per line.
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_reactnativemediapipellm_MediapipeLlmModule_nativeDumpLogs(
+    JNIEnv *env, jobject thiz, jint max_records) {
+    
+    size_t maxRecords = max_records > 0 ? static_cast<size_t>(max_records) : mediapipe_llm::Logger::kHistoryCapacity;
+    return env->NewStringUTF(mediapipe_llm::Logger::shared().dump(maxRecords).c_str());
+}
+
 void MediapipeLlm::setupAndroidImageLoader() {
-    LOGI("Setting up Android image loader");
+    LLM_LOGD(ImageLoaderSetup);
 }
 
 std::string MediapipeLlm::loadImageFromUri(const std::string& uri) {
-    LOGI("Loading image from URI: %s", uri.c_str());
+    LLM_LOGD(ImageLoad, uri.size());
     return uri;
 }
 
@@ -215,6 +270,10 @@ public:
     MediapipeLlmModule(const facebook::react::TurboModuleSpec& spec)
         : TurboModule(spec) {
         module_ = std::make_shared<MediapipeLlm>();
+        auto jsInvoker = spec.jsInvoker;
+        module_->setJsScheduler([jsInvoker](std::function<void()> fn) {
+            jsInvoker->invokeAsync(std::move(fn));
+        });
     }
     
     facebook::jsi::Value get(facebook::jsi::Runtime& runtime, const facebook::jsi::PropNameID& propName) override {
@@ -270,6 +329,6 @@ Java_com_reactnativemediapipellm_MediapipeLlmModule_nativeMultiply(JNIEnv *env,
 
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
     return facebook::jni::initialize(vm, [] {
-        LOGI("MediapipeLlm JNI_OnLoad");
+        LLM_LOGI(JniLoad);
     });
 } 
\ No newline at end of file
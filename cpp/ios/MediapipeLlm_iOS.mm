@@ -1,4 +1,5 @@
 #include "../MediapipeLlm.h"
+#include "../Logger.h"
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 #import <React/RCTBridge+Private.h>
@@ -12,12 +13,12 @@ using namespace std;
 namespace mediapipe_llm {
 
 void MediapipeLlm::setupiOSImageLoader() {
-    NSLog(@"Setting up iOS image loader");
+    LLM_LOGD(ImageLoaderSetup);
 }
 
 std::string MediapipeLlm::loadImageFromUri(const std::string& uri) {
     NSString *uriString = [NSString stringWithUTF8String:uri.c_str()];
-    NSLog(@"Loading image from URI: %@", uriString);
+    LLM_LOGD(ImageLoad, uri.size());
     
     NSData *imageData = nil;
     
@@ -31,7 +32,7 @@ std::string MediapipeLlm::loadImageFromUri(const std::string& uri) {
             imageData = [[NSData alloc] initWithBase64EncodedString:base64String options:0];
         }
     } else if ([uriString hasPrefix:@"assets-library://"] || [uriString hasPrefix:@"ph://"]) {
-        NSLog(@"Photo library URIs not yet implemented");
+        LLM_LOGW(ImageSourceUnsupported);
     }
     
     if (imageData) {
@@ -70,6 +71,13 @@ RCT_EXPORT_MODULE()
         return;
     }
     
+    auto jsInvoker = cxxBridge.jsCallInvoker;
+    if (jsInvoker) {
+        _module->setJsScheduler([jsInvoker](std::function<void()> fn) {
+            jsInvoker->invokeAsync(std::move(fn));
+        });
+    }
+    
     _module->install(*(facebook::jsi::Runtime *)cxxBridge.runtime);
 }
 
@@ -0,0 +1,237 @@
+// Checks DraftPrefill's prefix bookkeeping against fake sessions that just
+// record their text: chunking, rewinds on edits, commit and cancellation.
+// Plain asserts and a non-zero exit on failure; run with ctest.
+
+#include "DraftPrefill.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace mediapipe_llm;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                         \
+        }                                                                       \
+    } while (0)
+
+struct FakeSession {
+    std::string text;
+};
+
+// Sessions are plain heap objects; the counters tell leaks and chunk sizes.
+struct FakeEngine {
+    std::atomic<int> live{0};
+    std::atomic<size_t> largestChunk{0};
+    std::atomic<bool> failChunks{false};
+
+    DraftSessionOps ops() {
+        DraftSessionOps ops;
+        ops.clone = [this](void* session) -> void* {
+            ++live;
+            return new FakeSession(*static_cast<FakeSession*>(session));
+        };
+        ops.addQueryChunk = [this](void* session, const std::string& text) {
+            if (failChunks) {
+                return false;
+            }
+            if (text.size() > largestChunk) {
+                largestChunk = text.size();
+            }
+            static_cast<FakeSession*>(session)->text += text;
+            return true;
+        };
+        ops.release = [this](void* session) {
+            --live;
+            delete static_cast<FakeSession*>(session);
+        };
+        return ops;
+    }
+};
+
+bool waitFor(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Commits and returns the resulting text, releasing the session handed back.
+std::string commitText(FakeEngine& engine, DraftPrefill& draft, const std::string& finalText) {
+    std::string error;
+    void* session = draft.commit(finalText, error);
+    CHECK(session != nullptr);
+    CHECK(error.empty());
+    if (!session) {
+        return "";
+    }
+    std::string text = static_cast<FakeSession*>(session)->text;
+    engine.ops().release(session);
+    return text;
+}
+
+void testStablePrefix() {
+    CHECK(DraftPrefill::stablePrefix("") == "");
+    CHECK(DraftPrefill::stablePrefix("hello") == "");
+    CHECK(DraftPrefill::stablePrefix("hello wor") == "hello");
+    CHECK(DraftPrefill::stablePrefix("hello world ") == "hello world");
+    CHECK(DraftPrefill::stablePrefix("hello  world\n") == "hello  world");
+}
+
+void testCommitWithoutPrefill() {
+    FakeEngine engine;
+    FakeSession base{"system: "};
+    {
+        DraftPrefill draft(&base, engine.ops());
+        CHECK(draft.valid());
+        CHECK(commitText(engine, draft, "hi") == "system: hi");
+        CHECK(draft.stats().prefilledChars == 0);
+
+        std::string error;
+        CHECK(draft.commit("again", error) == nullptr);
+        CHECK(!error.empty());
+    }
+    CHECK(engine.live == 0);
+    CHECK(base.text == "system: ");
+}
+
+void testCommitAddsOnlyTheTail() {
+    FakeEngine engine;
+    FakeSession base;
+    {
+        DraftPrefill draft(&base, engine.ops());
+        std::string typed = "please summarise the following article for me in thr";
+        draft.update(typed);
+        CHECK(waitFor([&] { return draft.stats().prefilledChars == DraftPrefill::stablePrefix(typed).size(); }));
+
+        std::string finalText = "please summarise the following article for me in three bullets";
+        CHECK(commitText(engine, draft, finalText) == finalText);
+        CHECK(draft.stats().prefilledChars == DraftPrefill::stablePrefix(typed).size());
+        CHECK(draft.stats().rewinds == 0);
+    }
+    CHECK(engine.live == 0);
+}
+
+void testEditRewindsToCheckpoint() {
+    FakeEngine engine;
+    FakeSession base;
+    {
+        DraftPrefill draft(&base, engine.ops());
+        std::string first = "the quick brown fox jumps over ";
+        draft.update(first);
+        CHECK(waitFor([&] { return draft.stats().prefilledChars == DraftPrefill::stablePrefix(first).size(); }));
+
+        std::string second = first + "the lazy dog and keeps on running ";
+        draft.update(second);
+        CHECK(waitFor([&] { return draft.stats().prefilledChars == DraftPrefill::stablePrefix(second).size(); }));
+        CHECK(draft.stats().chunks == 2);
+
+        // Editing inside the second chunk drops it but keeps the first.
+        std::string edited = first + "the lazy cat";
+        CHECK(commitText(engine, draft, edited) == edited);
+        DraftPrefillStats stats = draft.stats();
+        CHECK(stats.rewinds == 1);
+        CHECK(stats.prefilledChars == DraftPrefill::stablePrefix(first).size());
+    }
+    CHECK(engine.live == 0);
+}
+
+void testEditBeforeEveryCheckpoint() {
+    FakeEngine engine;
+    FakeSession base{"ctx|"};
+    {
+        DraftPrefill draft(&base, engine.ops());
+        std::string typed = "write a short poem about the sea ";
+        draft.update(typed);
+        CHECK(waitFor([&] { return draft.stats().chunks == 1; }));
+
+        // Nothing prefilled survives; commit starts from the root clone.
+        CHECK(commitText(engine, draft, "translate this") == "ctx|translate this");
+        CHECK(draft.stats().prefilledChars == 0);
+    }
+    CHECK(engine.live == 0);
+}
+
+void testLongDraftIsChunked() {
+    FakeEngine engine;
+    FakeSession base;
+    {
+        DraftPrefill draft(&base, engine.ops());
+        std::string typed;
+        while (typed.size() < 10 * DraftPrefill::kMaxChunkChars) {
+            typed += "lorem ipsum dolor sit amet ";
+        }
+        draft.update(typed);
+        CHECK(waitFor([&] { return draft.stats().prefilledChars == DraftPrefill::stablePrefix(typed).size(); }));
+        CHECK(draft.stats().chunks >= 10);
+        CHECK(engine.largestChunk <= DraftPrefill::kMaxChunkChars);
+
+        // Chunks are cut at whitespace, so the pieces add up to the text.
+        CHECK(commitText(engine, draft, typed + "end") == typed + "end");
+    }
+    CHECK(engine.live == 0);
+}
+
+void testFailedChunkStopsPrefill() {
+    FakeEngine engine;
+    FakeSession base;
+    {
+        DraftPrefill draft(&base, engine.ops());
+        engine.failChunks = true;
+        draft.update("this chunk will not be accepted by the engine ");
+        CHECK(waitFor([&] { return draft.isStopped(); }));
+        CHECK(draft.stats().prefilledChars == 0);
+        CHECK(engine.live == 1);  // only the root clone
+    }
+    CHECK(engine.live == 0);
+}
+
+void testCancelDoesNotWait() {
+    FakeEngine engine;
+    FakeSession base;
+    {
+        DraftPrefill draft(&base, engine.ops());
+        CHECK(!draft.isStopped());
+        draft.cancel();
+        CHECK(waitFor([&] { return draft.isStopped(); }));
+        // Updates after cancelling are ignored by the stopped worker.
+        draft.update("some more text that should never be prefilled ");
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        CHECK(draft.stats().chunks == 0);
+    }
+    CHECK(engine.live == 0);
+}
+
+} // namespace
+
+int main() {
+    testStablePrefix();
+    testCommitWithoutPrefill();
+    testCommitAddsOnlyTheTail();
+    testEditRewindsToCheckpoint();
+    testEditBeforeEveryCheckpoint();
+    testLongDraftIsChunked();
+    testFailedChunkStopsPrefill();
+    testCancelDoesNotWait();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("DraftPrefillTest: all checks passed\n");
+    return 0;
+}
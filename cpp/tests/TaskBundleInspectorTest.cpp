@@ -0,0 +1,340 @@
+// Checks the .task bundle parsers against hand-built zip, protobuf and
+// flatbuffer bytes. Plain asserts and a non-zero exit on failure; run with
+// ctest.
+
+#include "TaskBundleInspector.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace mediapipe_llm;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                         \
+        }                                                                       \
+    } while (0)
+
+using Bytes = std::vector<uint8_t>;
+
+void put16(Bytes& out, uint16_t value) {
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+void put32(Bytes& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out.push_back((value >> (8 * i)) & 0xFF);
+}
+
+void patch32(Bytes& out, size_t at, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[at + i] = (value >> (8 * i)) & 0xFF;
+}
+
+// Stored (uncompressed) zip; CRCs are left zero since the parser ignores them.
+Bytes buildZip(const std::vector<std::pair<std::string, Bytes>>& members) {
+    Bytes zip;
+    std::vector<uint32_t> offsets;
+    for (const auto& member : members) {
+        offsets.push_back(static_cast<uint32_t>(zip.size()));
+        put32(zip, 0x04034b50);
+        put16(zip, 20);  // version needed
+        put16(zip, 0);   // flags
+        put16(zip, 0);   // method: stored
+        put32(zip, 0);   // time, date
+        put32(zip, 0);   // crc
+        put32(zip, static_cast<uint32_t>(member.second.size()));
+        put32(zip, static_cast<uint32_t>(member.second.size()));
+        put16(zip, static_cast<uint16_t>(member.first.size()));
+        put16(zip, 0);  // extra
+        zip.insert(zip.end(), member.first.begin(), member.first.end());
+        zip.insert(zip.end(), member.second.begin(), member.second.end());
+    }
+
+    uint32_t directoryOffset = static_cast<uint32_t>(zip.size());
+    for (size_t i = 0; i < members.size(); ++i) {
+        const auto& member = members[i];
+        put32(zip, 0x02014b50);
+        put16(zip, 20);  // version made by
+        put16(zip, 20);  // version needed
+        put16(zip, 0);   // flags
+        put16(zip, 0);   // method
+        put32(zip, 0);   // time, date
+        put32(zip, 0);   // crc
+        put32(zip, static_cast<uint32_t>(member.second.size()));
+        put32(zip, static_cast<uint32_t>(member.second.size()));
+        put16(zip, static_cast<uint16_t>(member.first.size()));
+        put16(zip, 0);  // extra
+        put16(zip, 0);  // comment
+        put16(zip, 0);  // disk
+        put16(zip, 0);  // internal attributes
+        put32(zip, 0);  // external attributes
+        put32(zip, offsets[i]);
+        zip.insert(zip.end(), member.first.begin(), member.first.end());
+    }
+    uint32_t directorySize = static_cast<uint32_t>(zip.size()) - directoryOffset;
+
+    put32(zip, 0x06054b50);
+    put16(zip, 0);
+    put16(zip, 0);
+    put16(zip, static_cast<uint16_t>(members.size()));
+    put16(zip, static_cast<uint16_t>(members.size()));
+    put32(zip, directorySize);
+    put32(zip, directoryOffset);
+    put16(zip, 0);  // comment
+    return zip;
+}
+
+// A SentencePiece ModelProto: `pieces` records (field 1) plus an unrelated
+// trainer_spec (field 2) and a varint field the parser must skip.
+Bytes buildTokenizer(const std::vector<std::string>& pieces) {
+    Bytes proto;
+    for (const auto& piece : pieces) {
+        // ModelProto.SentencePiece { piece = 1 (string) }
+        Bytes inner;
+        inner.push_back((1 << 3) | 2);
+        inner.push_back(static_cast<uint8_t>(piece.size()));
+        inner.insert(inner.end(), piece.begin(), piece.end());
+        proto.push_back((1 << 3) | 2);
+        proto.push_back(static_cast<uint8_t>(inner.size()));
+        proto.insert(proto.end(), inner.begin(), inner.end());
+    }
+    proto.push_back((2 << 3) | 2);
+    proto.push_back(2);
+    proto.push_back(0x08);
+    proto.push_back(0x01);
+    proto.push_back((5 << 3) | 0);
+    proto.push_back(0xAC);  // 300 as a two-byte varint
+    proto.push_back(0x02);
+    return proto;
+}
+
+struct TensorSpec {
+    std::string name;
+    std::vector<int32_t> shape;
+    int8_t type;
+    uint32_t buffer;
+};
+
+// Forward-only flatbuffer writer. Every uoffset points at something written
+// after it, so slots are patched once their target exists.
+class FlatWriter {
+public:
+    // Writes a vtable followed by a table with `fields` 4-byte slots, all
+    // present; returns the table position. Slot i is at table + 4 + 4 * i.
+    size_t table(int fields) {
+        align();
+        size_t vtable = bytes.size();
+        put16(bytes, static_cast<uint16_t>(4 + 2 * fields));
+        put16(bytes, static_cast<uint16_t>(4 + 4 * fields));
+        for (int i = 0; i < fields; ++i) put16(bytes, static_cast<uint16_t>(4 + 4 * i));
+        align();
+        size_t table = bytes.size();
+        put32(bytes, static_cast<uint32_t>(table - vtable));  // soffset to the vtable
+        for (int i = 0; i < fields; ++i) put32(bytes, 0);
+        return table;
+    }
+
+    size_t vector(size_t length) {
+        align();
+        size_t at = bytes.size();
+        put32(bytes, static_cast<uint32_t>(length));
+        for (size_t i = 0; i < length; ++i) put32(bytes, 0);
+        return at;
+    }
+
+    size_t string(const std::string& value) {
+        align();
+        size_t at = bytes.size();
+        put32(bytes, static_cast<uint32_t>(value.size()));
+        bytes.insert(bytes.end(), value.begin(), value.end());
+        bytes.push_back(0);
+        return at;
+    }
+
+    void link(size_t slot, size_t target) { patch32(bytes, slot, static_cast<uint32_t>(target - slot)); }
+    void set(size_t slot, uint32_t value) { patch32(bytes, slot, value); }
+
+    Bytes bytes;
+
+private:
+    void align() {
+        while (bytes.size() % 4) bytes.push_back(0);
+    }
+};
+
+// Model { subgraphs (field 2) } -> SubGraph { tensors (field 0) } -> Tensor
+// { shape, type, buffer, name }.
+Bytes buildGraph(const std::vector<TensorSpec>& tensors) {
+    FlatWriter writer;
+    writer.bytes.resize(4);  // root uoffset
+    size_t model = writer.table(3);
+    writer.link(0, model);
+
+    size_t subgraphs = writer.vector(1);
+    writer.link(model + 4 + 4 * 2, subgraphs);
+    size_t subgraph = writer.table(1);
+    writer.link(subgraphs + 4, subgraph);
+
+    size_t tensorVector = writer.vector(tensors.size());
+    writer.link(subgraph + 4, tensorVector);
+    for (size_t i = 0; i < tensors.size(); ++i) {
+        const auto& spec = tensors[i];
+        size_t tensor = writer.table(4);
+        writer.link(tensorVector + 4 + 4 * i, tensor);
+        writer.set(tensor + 4 + 4 * 1, static_cast<uint8_t>(spec.type));
+        writer.set(tensor + 4 + 4 * 2, spec.buffer);
+
+        size_t shape = writer.vector(spec.shape.size());
+        writer.link(tensor + 4, shape);
+        for (size_t d = 0; d < spec.shape.size(); ++d) {
+            writer.set(shape + 4 + 4 * d, static_cast<uint32_t>(spec.shape[d]));
+        }
+        writer.link(tensor + 4 + 4 * 3, writer.string(spec.name));
+    }
+    return writer.bytes;
+}
+
+const std::vector<TensorSpec> kTensors = {
+    {"kv_cache_k_0", {1, 1024, 2, 64}, 0, 0},  // float32 cache input
+    {"kv_cache_v_0", {1, 1024, 2, 64}, 0, 0},
+    {"layer_0/attn/w", {64, 64}, 9, 1},        // int8 weights dominate
+    {"layer_0/attn/b", {8, 8}, 0, 2},
+    {"input_pos", {1}, 2, 0},                  // rank 1: neither cache nor weight
+};
+
+void testZipDirectory() {
+    Bytes zip = buildZip({{"TOKENIZER_MODEL", Bytes(5, 1)}, {"METADATA", Bytes(3, 2)}});
+    std::vector<TaskBundleEntry> entries;
+    std::string error;
+    CHECK(TaskBundleInspector::parseZipDirectory(zip.data(), zip.size(), entries, error));
+    CHECK(entries.size() == 2);
+    if (entries.size() == 2) {
+        CHECK(entries[0].name == "TOKENIZER_MODEL");
+        CHECK(entries[0].uncompressedSize == 5);
+        CHECK(entries[0].method == 0);
+        CHECK(zip[entries[0].dataOffset] == 1);
+        CHECK(entries[1].name == "METADATA");
+        CHECK(zip[entries[1].dataOffset] == 2);
+    }
+
+    // A trailing archive comment moves the end record away from the tail.
+    Bytes commented = zip;
+    commented[commented.size() - 2] = 4;
+    commented.insert(commented.end(), {'n', 'o', 't', 'e'});
+    entries.clear();
+    CHECK(TaskBundleInspector::parseZipDirectory(commented.data(), commented.size(), entries, error));
+    CHECK(entries.size() == 2);
+}
+
+void testZipRejectsCorruptInput() {
+    std::vector<TaskBundleEntry> entries;
+    std::string error;
+
+    Bytes tiny(10, 0);
+    CHECK(!TaskBundleInspector::parseZipDirectory(tiny.data(), tiny.size(), entries, error));
+
+    Bytes noEndRecord(200, 0x41);
+    error.clear();
+    CHECK(!TaskBundleInspector::parseZipDirectory(noEndRecord.data(), noEndRecord.size(), entries, error));
+    CHECK(!error.empty());
+
+    // Central directory offset pointing past the end of the file.
+    Bytes zip = buildZip({{"TF_LITE_PREFILL_DECODE", Bytes(4, 0)}});
+    patch32(zip, zip.size() - 6, 0x7FFFFFFF);
+    error.clear();
+    CHECK(!TaskBundleInspector::parseZipDirectory(zip.data(), zip.size(), entries, error));
+    CHECK(!error.empty());
+
+    // Local header offset pointing into the middle of nowhere.
+    zip = buildZip({{"TF_LITE_PREFILL_DECODE", Bytes(4, 0)}});
+    size_t directory = zip.size() - 22 - (46 + strlen("TF_LITE_PREFILL_DECODE"));
+    patch32(zip, directory + 42, 3);
+    entries.clear();
+    error.clear();
+    CHECK(!TaskBundleInspector::parseZipDirectory(zip.data(), zip.size(), entries, error));
+    CHECK(!error.empty());
+}
+
+void testTokenizer() {
+    Bytes proto = buildTokenizer({"<pad>", "<s>", "</s>", "hello"});
+    CHECK(TaskBundleInspector::countTokenizerPieces(proto.data(), proto.size()) == 4);
+
+    CHECK(TaskBundleInspector::countTokenizerPieces(proto.data(), 0) == 0);
+
+    // A length prefix running off the end is malformed, not a short count.
+    Bytes truncated(proto.begin(), proto.begin() + 5);
+    CHECK(TaskBundleInspector::countTokenizerPieces(truncated.data(), truncated.size()) == -1);
+}
+
+void testModelGraph() {
+    Bytes graph = buildGraph(kTensors);
+    ModelCapabilities caps;
+    TaskBundleInspector::parseModelGraph(graph.data(), graph.size(), caps);
+    CHECK(caps.contextLength == 1024);
+    CHECK(caps.kvCacheBytes == 2ULL * 1024 * 2 * 64 * 4);
+    CHECK(caps.weightType == "int8");
+
+    // Garbage must leave the defaults alone rather than read out of bounds.
+    Bytes garbage(64, 0xFF);
+    ModelCapabilities untouched;
+    TaskBundleInspector::parseModelGraph(garbage.data(), garbage.size(), untouched);
+    CHECK(untouched.contextLength == -1);
+    CHECK(untouched.kvCacheBytes == 0);
+    CHECK(untouched.weightType == "unknown");
+}
+
+void testBundle() {
+    Bytes graph = buildGraph(kTensors);
+    Bytes bundle = buildZip({
+        {"TOKENIZER_MODEL", buildTokenizer({"a", "b", "c"})},
+        {"TF_LITE_PREFILL_DECODE", graph},
+        {"TF_LITE_VISION_ENCODER", Bytes(16, 0)},
+    });
+
+    ModelCapabilities caps;
+    TaskBundleInspector::inspectBytes(bundle.data(), bundle.size(), caps);
+    CHECK(caps.ok);
+    CHECK(caps.error.empty());
+    CHECK(caps.entries.size() == 3);
+    CHECK(caps.vocabSize == 3);
+    CHECK(caps.contextLength == 1024);
+    CHECK(caps.supportsVision);
+    CHECK(!caps.supportsAudio);
+    CHECK(caps.weightBytes == graph.size() + 16);
+    CHECK(caps.fileSizeBytes == bundle.size());
+    CHECK(caps.estimatedMemoryBytes > caps.weightBytes + caps.kvCacheBytes);
+}
+
+void testBundleWithoutGraph() {
+    Bytes zip = buildZip({{"TOKENIZER_MODEL", buildTokenizer({"a"})}, {"README", Bytes(8, 'x')}});
+    ModelCapabilities caps;
+    TaskBundleInspector::inspectBytes(zip.data(), zip.size(), caps);
+    CHECK(!caps.ok);
+    CHECK(!caps.error.empty());
+}
+
+} // namespace
+
+int main() {
+    testZipDirectory();
+    testZipRejectsCorruptInput();
+    testTokenizer();
+    testModelGraph();
+    testBundle();
+    testBundleWithoutGraph();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("TaskBundleInspectorTest: all checks passed\n");
+    return 0;
+}
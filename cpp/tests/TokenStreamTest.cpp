@@ -0,0 +1,170 @@
+// Checks TokenStream's notify coalescing, backpressure and cancellation with
+// a producer thread standing in for the engine. Plain asserts and a non-zero
+// exit on failure; run with ctest.
+
+#include "TokenStream.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using namespace mediapipe_llm;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                         \
+        }                                                                       \
+    } while (0)
+
+// Waits for the producer to park on backpressure; false if it never does.
+bool waitForBackpressure(const TokenStream& stream, uint64_t waits) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (stream.stats().backpressureWaits < waits) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void testNotifyCoalescing() {
+    TokenStreamOptions options;
+    options.notifyInterval = std::chrono::hours(1);
+    int notified = 0;
+    TokenStream stream(options, [&] { ++notified; });
+
+    // The first token wakes the consumer; the rest ride along with it.
+    stream.append("a", 1);
+    stream.append("b", 1);
+    stream.append("c", 1);
+    CHECK(notified == 1);
+
+    bool finished = true;
+    CHECK(stream.take(finished) == "abc");
+    CHECK(!finished);
+
+    // Drained, but still inside the interval: no new wake-up yet.
+    stream.append("d", 1);
+    CHECK(notified == 1);
+
+    // The end of the stream is always delivered straight away.
+    stream.finish();
+    CHECK(notified == 2);
+    CHECK(stream.take(finished) == "d");
+    CHECK(finished);
+    CHECK(stream.error().empty());
+
+    TokenStreamStats stats = stream.stats();
+    CHECK(stats.bytesWritten == 4);
+    CHECK(stats.bytesRead == 4);
+    CHECK(stats.notifications == 2);
+    CHECK(stats.backpressureWaits == 0);
+}
+
+void testNoNotifyWhilePending() {
+    TokenStreamOptions options;
+    options.notifyInterval = std::chrono::milliseconds(0);
+    int notified = 0;
+    TokenStream stream(options, [&] { ++notified; });
+
+    // With no interval the consumer is still woken only once per batch.
+    stream.append("a", 1);
+    stream.append("b", 1);
+    stream.finish("boom");
+    CHECK(notified == 1);
+
+    bool finished = false;
+    CHECK(stream.take(finished) == "ab");
+    CHECK(finished);
+    CHECK(stream.error() == "boom");
+}
+
+void testBackpressure(size_t highWaterBytes) {
+    TokenStreamOptions options;
+    options.highWaterBytes = highWaterBytes;
+    int notified = 0;
+    TokenStream stream(options, [&] { ++notified; });
+
+    std::string first(highWaterBytes ? highWaterBytes : 1, 'x');
+    CHECK(stream.append(first.data(), first.size()));
+
+    std::atomic<bool> appended{false};
+    std::thread producer([&] {
+        appended = stream.append("y", 1);
+        stream.finish();
+    });
+
+    CHECK(waitForBackpressure(stream, 1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(!appended);
+
+    bool finished = false;
+    CHECK(stream.take(finished) == first);
+    producer.join();
+    CHECK(appended);
+    CHECK(stream.take(finished) == "y");
+    CHECK(finished);
+    CHECK(stream.stats().backpressureWaits == 1);
+}
+
+void testCancelWakesProducer() {
+    TokenStreamOptions options;
+    options.highWaterBytes = 2;
+    TokenStream stream(options, nullptr);
+    CHECK(stream.append("ab", 2));
+
+    std::atomic<bool> returned{false};
+    std::atomic<bool> appended{true};
+    std::thread producer([&] {
+        appended = stream.append("c", 1);
+        returned = true;
+    });
+
+    CHECK(waitForBackpressure(stream, 1));
+    stream.cancel();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!returned && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(returned);
+    CHECK(!appended);
+    CHECK(stream.isCancelled());
+
+    // Cancelled but not yet wound down: the consumer must keep waiting.
+    bool finished = true;
+    stream.take(finished);
+    CHECK(!finished);
+    CHECK(!stream.waitFinished(std::chrono::steady_clock::now()));
+
+    stream.finish();
+    producer.join();
+    CHECK(stream.waitFinished(std::chrono::steady_clock::now()));
+    stream.take(finished);
+    CHECK(finished);
+    CHECK(!stream.append("d", 1));
+}
+
+} // namespace
+
+int main() {
+    testNotifyCoalescing();
+    testNoNotifyWhilePending();
+    testBackpressure(4);
+    testBackpressure(0);
+    testCancelWakesProducer();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("TokenStreamTest: all checks passed\n");
+    return 0;
+}